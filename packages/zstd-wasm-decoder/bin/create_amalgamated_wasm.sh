@@ -26,6 +26,17 @@ if [ $? -ne 0 ]; then
   exit 1
 fi
 
+# Local changes to the vendored sources, each one behind its own macro (see patches/)
+for PATCH in "$SCRIPT_DIR"/patches/*.patch; do
+  [ -e "$PATCH" ] || continue
+  echo "Applying $(basename "$PATCH")..."
+  if ! patch -s -p1 -d "$TEMP_LIB" < "$PATCH"; then
+    echo "ERROR: $(basename "$PATCH") does not apply"
+    rm -rf "$TEMP_LIB"
+    exit 1
+  fi
+done
+
 echo "Amalgamating with WASM wrapper..."
 python3 "$COMBINE_SCRIPT" \
   -r "$TEMP_LIB" \
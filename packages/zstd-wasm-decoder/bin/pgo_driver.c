@@ -0,0 +1,122 @@
+/**
+ * \file pgo_driver.c
+ * Host-side training driver for `make perf-pgo`.
+ *
+ * Links against a natively compiled (and instrumented) zstd_wasm_amalgamated.c
+ * and replays every input through the same entry points the JS wrapper uses:
+ *  - dS  : single pass, as ZstdDecoder.decompressSync
+ *  - ds  : streaming, staged in the same 262150b input steps as ZstdDecoder.decompressStream
+ *
+ * The resulting profile is keyed on the amalgamation's function names, which is what
+ * -fprofile-instr-use matches against when the wasm module is built.
+ *
+ * Usage: pgo_driver [-D dict] file.zst [file.zst ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Mirrors ZstdBufsObject in zstd_wasm_full.c */
+typedef struct { const void* src; size_t size; size_t pos; } in_buffer_t;
+typedef struct { void* dst; size_t size; size_t pos; } out_buffer_t;
+typedef struct {
+    in_buffer_t in_buffer;
+    unsigned char pad[4];
+    out_buffer_t out_buffer;
+    unsigned char pad2[4];
+} __attribute__((aligned(32))) bufs_t;
+
+void _initialize(void);
+void re(void);
+void cd(const void* dict, size_t dictSize);
+size_t dS(void* dst, size_t dstCapacity, const void* src, size_t srcSize);
+size_t ds(void);
+void* getInBufferPtr(void);
+
+#define MAX_DST_BUF 9830464
+#define STREAM_IN_STEP 262150
+#define STREAM_OUT_SIZE 917501
+
+static int is_error(size_t code) {
+    return code > (size_t)-120;
+}
+
+static unsigned char* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    unsigned char* buf;
+    long len;
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = (unsigned char*)malloc(len > 0 ? (size_t)len : 1);
+    if (buf && fread(buf, 1, (size_t)len, f) != (size_t)len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *size = (size_t)len;
+    return buf;
+}
+
+static int run_stream(bufs_t* bufs, const unsigned char* src, size_t srcSize, unsigned char* dst) {
+    size_t offset = 0;
+    re();
+    while (offset < srcSize) {
+        size_t const toProcess = srcSize - offset < STREAM_IN_STEP ? srcSize - offset : STREAM_IN_STEP;
+        bufs->in_buffer.src = src + offset;
+        bufs->in_buffer.size = toProcess;
+        bufs->in_buffer.pos = 0;
+        while (bufs->in_buffer.pos < toProcess) {
+            bufs->out_buffer.dst = dst;
+            bufs->out_buffer.size = STREAM_OUT_SIZE;
+            bufs->out_buffer.pos = 0;
+            if (is_error(ds())) return 1;
+        }
+        offset += toProcess;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    bufs_t* const bufs = (bufs_t*)getInBufferPtr();
+    unsigned char* const dst = (unsigned char*)malloc(MAX_DST_BUF);
+    unsigned char* dict = NULL;
+    size_t dictSize = 0;
+    int failures = 0, files = 0, i = 1;
+
+    if (!dst) return 1;
+    _initialize();
+
+    if (argc > 2 && strcmp(argv[1], "-D") == 0) {
+        dict = read_file(argv[2], &dictSize);
+        if (!dict) {
+            fprintf(stderr, "cannot read dictionary %s\n", argv[2]);
+            return 1;
+        }
+        cd(dict, dictSize);
+        i = 3;
+    }
+
+    for (; i < argc; ++i) {
+        size_t srcSize = 0;
+        unsigned char* const src = read_file(argv[i], &srcSize);
+        if (!src) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            ++failures;
+            continue;
+        }
+        /* Frames larger than the single pass buffer take the streaming path in JS as well */
+        re();
+        (void)dS(dst, MAX_DST_BUF, src, srcSize);
+        if (run_stream(bufs, src, srcSize, dst)) ++failures;
+        ++files;
+        free(src);
+    }
+
+    printf("pgo: trained on %d files (%d failed)\n", files, failures);
+    free(dst);
+    free(dict);
+    return files == 0;
+}
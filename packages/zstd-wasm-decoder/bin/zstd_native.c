@@ -0,0 +1,256 @@
+/**
+ * \file zstd_native.c
+ * N-API shim around a natively compiled zstd_wasm_amalgamated.c (`make native`).
+ *
+ * The amalgamation is built as its own translation unit: its freestanding stddef / stdint
+ * can't share one with node_api.h. The wasm entry points (re, cd, dS, ds) work on a single
+ * static context, so this shim goes through the public streaming API instead and keeps
+ * one ZSTD_DCtx (+ optional ZSTD_DDict) per decoder handle.
+ *
+ * Natively the decoder keeps what the wasm builds compile out: both huffman decoders,
+ * the long offset sequence path, prefetching and DYNAMIC_BMI2 dispatch.
+ *
+ * Exports (wrapped by ZstdNativeDecoder in zstd-native.ts):
+ *  - create(dict?)                          -> handle
+ *  - dS(handle, src, dstCapacity)           -> Buffer   (single pass, as dS)
+ *  - ds(handle, src, reset, maxDstSize)     -> Buffer   (streaming, as ds)
+ *  - mf(handle)                             -> boolean  (stream stopped inside a frame, as dl)
+ *
+ * Errors are thrown with the same messages as the wasm wrapper (`dec err -<code>`).
+ */
+
+#include <node_api.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Public zstd API, as compiled into zstd_wasm_amalgamated.c (ZSTD_STATIC_LINKING_ONLY) */
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+typedef struct ZSTD_DDict_s ZSTD_DDict;
+typedef struct { const void* src; size_t size; size_t pos; } ZSTD_inBuffer;
+typedef struct { void* dst; size_t size; size_t pos; } ZSTD_outBuffer;
+
+ZSTD_DCtx* ZSTD_createDCtx(void);
+size_t ZSTD_freeDCtx(ZSTD_DCtx* dctx);
+ZSTD_DDict* ZSTD_createDDict(const void* dictBuffer, size_t dictSize);
+size_t ZSTD_freeDDict(ZSTD_DDict* ddict);
+size_t ZSTD_DCtx_refDDict(ZSTD_DCtx* dctx, const ZSTD_DDict* ddict);
+size_t ZSTD_DCtx_setParameter(ZSTD_DCtx* dctx, int param, int value);
+size_t ZSTD_DCtx_reset(ZSTD_DCtx* dctx, int reset);
+size_t ZSTD_decompress_usingDDict(ZSTD_DCtx* dctx, void* dst, size_t dstCapacity,
+                                  const void* src, size_t srcSize, const ZSTD_DDict* ddict);
+size_t ZSTD_decompressStream(ZSTD_DCtx* zds, ZSTD_outBuffer* output, ZSTD_inBuffer* input);
+size_t ZSTD_DStreamOutSize(void);
+unsigned ZSTD_isError(size_t code);
+
+#define ZSTD_d_windowLogMax 100
+#define ZSTD_reset_session_only 1
+
+/* Same window limit as _initialize (maxWindowSize = 8388609) */
+#define NATIVE_WINDOW_LOG_MAX 23
+
+typedef struct {
+    ZSTD_DCtx* dctx;
+    ZSTD_DDict* ddict;
+    /* Single pass output, allocated on first use (dstCapacity is fixed by the wrapper) */
+    unsigned char* dst;
+    size_t dstCapacity;
+    /* Streaming output, grown on demand and reused across calls */
+    unsigned char* out;
+    size_t outCapacity;
+    /* Last ZSTD_decompressStream hint: 0 once a frame is decoded and flushed */
+    size_t hint;
+} native_decoder_t;
+
+static napi_value throw_code(napi_env env, size_t code) {
+    char msg[32];
+    snprintf(msg, sizeof(msg), "dec err %lld", (long long)(ptrdiff_t)code);
+    napi_throw_error(env, NULL, msg);
+    return NULL;
+}
+
+static napi_value throw_msg(napi_env env, const char* msg) {
+    napi_throw_error(env, NULL, msg);
+    return NULL;
+}
+
+static void finalize_decoder(napi_env env, void* data, void* hint) {
+    native_decoder_t* const dec = (native_decoder_t*)data;
+    (void)env;
+    (void)hint;
+    ZSTD_freeDCtx(dec->dctx);
+    ZSTD_freeDDict(dec->ddict);
+    free(dec->dst);
+    free(dec->out);
+    free(dec);
+}
+
+static native_decoder_t* get_decoder(napi_env env, napi_value handle) {
+    void* data = NULL;
+    if (napi_get_value_external(env, handle, &data) != napi_ok || !data) {
+        throw_msg(env, "not init");
+        return NULL;
+    }
+    return (native_decoder_t*)data;
+}
+
+static int get_bytes(napi_env env, napi_value value, const void** data, size_t* size) {
+    napi_typedarray_type type;
+    napi_value buffer;
+    size_t offset;
+    void* ptr = NULL;
+    if (napi_get_typedarray_info(env, value, &type, size, &ptr, &buffer, &offset) != napi_ok
+        || type != napi_uint8_array) {
+        throw_msg(env, "expected Uint8Array");
+        return 0;
+    }
+    *data = ptr;
+    return 1;
+}
+
+static napi_value create(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    napi_valuetype type = napi_undefined;
+    napi_value handle;
+    native_decoder_t* dec;
+
+    napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+    dec = (native_decoder_t*)calloc(1, sizeof(native_decoder_t));
+    if (!dec || !(dec->dctx = ZSTD_createDCtx())) {
+        free(dec);
+        return throw_msg(env, "dctx alloc");
+    }
+    ZSTD_DCtx_setParameter(dec->dctx, ZSTD_d_windowLogMax, NATIVE_WINDOW_LOG_MAX);
+
+    if (argc > 0) napi_typeof(env, argv[0], &type);
+    if (type == napi_object) {
+        const void* dict;
+        size_t dictSize;
+        if (!get_bytes(env, argv[0], &dict, &dictSize)) {
+            finalize_decoder(env, dec, NULL);
+            return NULL;
+        }
+        /* Copied: the JS dictionary may be detached or reused afterwards */
+        dec->ddict = ZSTD_createDDict(dict, dictSize);
+        if (!dec->ddict) {
+            finalize_decoder(env, dec, NULL);
+            return throw_msg(env, "dict err");
+        }
+        ZSTD_DCtx_refDDict(dec->dctx, dec->ddict);
+    }
+
+    if (napi_create_external(env, dec, finalize_decoder, NULL, &handle) != napi_ok) {
+        finalize_decoder(env, dec, NULL);
+        return throw_msg(env, "dctx alloc");
+    }
+    return handle;
+}
+
+/* Single pass: multi-frame, skippable frames ignored. Same as dS. */
+static napi_value decompress_sync(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3];
+    native_decoder_t* dec;
+    const void* src;
+    size_t srcSize, result;
+    uint32_t dstCapacity;
+    napi_value out;
+
+    napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+    if (argc < 3 || !(dec = get_decoder(env, argv[0]))) return NULL;
+    if (!get_bytes(env, argv[1], &src, &srcSize)) return NULL;
+    napi_get_value_uint32(env, argv[2], &dstCapacity);
+
+    if (dec->dstCapacity < dstCapacity) {
+        free(dec->dst);
+        dec->dst = (unsigned char*)malloc(dstCapacity);
+        dec->dstCapacity = dec->dst ? dstCapacity : 0;
+        if (!dec->dst) return throw_msg(env, "dst alloc");
+    }
+
+    result = ZSTD_decompress_usingDDict(dec->dctx, dec->dst, dstCapacity, src, srcSize, dec->ddict);
+    if (ZSTD_isError(result)) return throw_code(env, result);
+
+    napi_create_buffer_copy(env, result, dec->dst, NULL, &out);
+    return out;
+}
+
+/* Streaming: consumes all of src, continues the current frame unless reset. Same as ds. */
+static napi_value decompress_stream(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value argv[4];
+    native_decoder_t* dec;
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    bool reset = false;
+    double maxDstSize = 0;
+    napi_value result;
+
+    napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+    if (argc < 4 || !(dec = get_decoder(env, argv[0]))) return NULL;
+    if (!get_bytes(env, argv[1], &in.src, &in.size)) return NULL;
+    napi_get_value_bool(env, argv[2], &reset);
+    napi_get_value_double(env, argv[3], &maxDstSize);
+    in.pos = 0;
+
+    if (reset) {
+        ZSTD_DCtx_reset(dec->dctx, ZSTD_reset_session_only);
+        dec->hint = 0;
+    }
+
+    if (!dec->out) {
+        dec->outCapacity = ZSTD_DStreamOutSize() * 8;
+        dec->out = (unsigned char*)malloc(dec->outCapacity);
+        if (!dec->out) return throw_msg(env, "dst alloc");
+    }
+    out.dst = dec->out;
+    out.size = dec->outCapacity;
+    out.pos = 0;
+
+    /* Done once the input is consumed with room left in the output, or the frame ended (0, all
+       flushed). A full output buffer may leave decoded data in the context: grown, called again */
+    for (;;) {
+        size_t const ret = ZSTD_decompressStream(dec->dctx, &out, &in);
+        if (ZSTD_isError(ret)) return throw_code(env, ret);
+        dec->hint = ret;
+        if ((double)out.pos > maxDstSize) return throw_msg(env, "dec size>maxDstSize lim");
+        if (out.pos < out.size || !ret) {
+            if (in.pos == in.size) break;
+            continue;
+        }
+        size_t const grown = out.size * 2;
+        unsigned char* const next = (unsigned char*)realloc(dec->out, grown);
+        if (!next) return throw_msg(env, "dst alloc");
+        dec->out = next;
+        dec->outCapacity = grown;
+        out.dst = next;
+        out.size = grown;
+    }
+
+    napi_create_buffer_copy(env, out.pos, dec->out, NULL, &result);
+    return result;
+}
+
+/* Whether the stream stopped inside a frame, as the dl() return value */
+static napi_value mid_frame(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    native_decoder_t* dec;
+    napi_value result;
+
+    napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+    if (argc < 1 || !(dec = get_decoder(env, argv[0]))) return NULL;
+    napi_get_boolean(env, dec->hint != 0, &result);
+    return result;
+}
+
+NAPI_MODULE_INIT() {
+    napi_property_descriptor props[] = {
+        { "create", NULL, create, NULL, NULL, NULL, napi_default, NULL },
+        { "dS", NULL, decompress_sync, NULL, NULL, NULL, napi_default, NULL },
+        { "ds", NULL, decompress_stream, NULL, NULL, NULL, napi_default, NULL },
+        { "mf", NULL, mid_frame, NULL, NULL, NULL, napi_default, NULL },
+    };
+    napi_define_properties(env, exports, sizeof(props) / sizeof(props[0]), props);
+    return exports;
+}
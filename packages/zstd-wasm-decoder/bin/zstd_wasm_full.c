@@ -82,9 +82,19 @@
 
 #include "stddef.h"
 #include "stdint.h"
+
+#ifdef __wasm__
 #include <wasm_simd128.h>
 
 #define WASM_EXPORT __attribute__((visibility("default")))
+// It is not read only, but the only way to have llvm respect the order since linker scripts are not working.
+#define WASM_PINNED __attribute__((section(".rodata")))
+#else
+// Host build of the same amalgamation (make perf-pgo). libc provides the allocator,
+// the layout pinning is meaningless (and .rodata would be mapped read-only).
+#define WASM_EXPORT
+#define WASM_PINNED
+#endif
 #define XXH_FORCE_MEMORY_ACCESS 2
 #include "common/zstd_deps.h"
 
@@ -102,7 +112,7 @@ typedef struct {
     unsigned char pad2[4];
 } __attribute__((aligned(32))) ZstdBufsObject;
 
-__attribute__((section(".rodata"))) // It is not read only, but the only way to have llvm respect the order since linker scripts are not working.
+WASM_PINNED
 
 // Same for decompression context
 // Rationale: Keep writes as far away as possible from the dctx, and the vital pointer structs (those above)
@@ -113,7 +123,7 @@ typedef struct {
     ZSTD_DCtx dctx;
 } __attribute__((aligned(16))) ZstdPadObject;
 
-__attribute__((section(".rodata")))
+WASM_PINNED
 static ZstdPadObject ZstdPad;
 static ZSTD_DCtx* dctx = &ZstdPad.dctx;
 
@@ -127,16 +137,116 @@ void* getInBufferPtr(void) {
     return (void*)in_buffer;
 }
 
+// Stream output struct written by js: 8208 in the fixed layout, moves with __memory_base in the
+// relocatable build (make pic)
+WASM_EXPORT
+ZSTD_outBuffer* ob(void) {
+    return out_buffer;
+}
+
+#ifdef __wasm__
 // Heap_cursor as internal mutable global with initialization
 extern unsigned char __heap_cursor;
 __asm__(
     ".globaltype __heap_cursor, i32\n"
     "__heap_cursor:\n"
 );
+#endif
 
 #include "decompress/zstd_decompress.c"
 #include "decompress/zstd_decompress_block.c"
 
+/*
+    Entropy table cache, ZSTD_WASM_TABLE_CACHE entries per table kind (0 or undefined disables it).
+
+    Message feeds of small frames from the same compressor repeat byte-identical Huffman tree
+    descriptions and FSE NCount headers, and building the tables dominates below ~1 KB per frame.
+    Built tables are kept keyed by those header bytes (hash + full compare), a hit copies the table
+    instead of rebuilding it. Hooks: HUF_readDTableX2_wksp, ZSTD_buildSeqTable (see patches/).
+    Reserved at init right after the DCtx, round-robin replacement.
+*/
+// Huffman hits, misses, FSE (LL/OF/ML) hits, misses
+static U32 tableCacheStats[4];
+
+// Counters, read from js (ZstdDecoder.tableCacheStats)
+WASM_EXPORT
+U32* tc(void) {
+    return tableCacheStats;
+}
+
+#if ZSTD_WASM_TABLE_CACHE
+// Longest Huffman tree description (1 + 128 bytes), NCount headers are shorter
+#define TABLE_CACHE_KEY_MAX 132
+
+typedef struct {
+    U32 hash;
+    U32 keySize;    // 0: empty slot
+    U32 tableSize;
+    BYTE key[TABLE_CACHE_KEY_MAX];
+} TableCacheEntry;
+
+// Per kind: Huffman, LL, OF, ML
+static const size_t tableCacheSizes[4] = {
+    HUF_DTABLE_SIZE(HUF_TABLELOG_MAX) * sizeof(HUF_DTable),
+    SEQSYMBOL_TABLE_SIZE(LLFSELog) * sizeof(ZSTD_seqSymbol),
+    SEQSYMBOL_TABLE_SIZE(OffFSELog) * sizeof(ZSTD_seqSymbol),
+    SEQSYMBOL_TABLE_SIZE(MLFSELog) * sizeof(ZSTD_seqSymbol),
+};
+static BYTE* tableCache[4];
+static U32 tableCacheNext[4];
+
+#define TABLE_CACHE_STRIDE(kind) ((sizeof(TableCacheEntry) + tableCacheSizes[kind] + 7) & ~(size_t)7)
+
+static void tableCacheInit(void) {
+    int kind;
+    for (kind = 0; kind < 4; kind++)
+        tableCache[kind] = (BYTE*)calloc(ZSTD_WASM_TABLE_CACHE, TABLE_CACHE_STRIDE(kind));
+}
+
+// FNV-1a
+static U32 tableCacheHash(const BYTE* key, size_t keySize) {
+    U32 h = 2166136261u;
+    size_t i;
+    for (i = 0; i < keySize; i++) h = (h ^ key[i]) * 16777619u;
+    return h;
+}
+
+static size_t ZSTD_wasm_tableCacheGet(int kind, const void* key, size_t keySize, void* table) {
+    BYTE* slot = tableCache[kind];
+    U32 hash;
+    int i;
+    if (!slot || keySize > TABLE_CACHE_KEY_MAX) return 0;
+    hash = tableCacheHash((const BYTE*)key, keySize);
+    for (i = 0; i < ZSTD_WASM_TABLE_CACHE; i++, slot += TABLE_CACHE_STRIDE(kind)) {
+        TableCacheEntry* const entry = (TableCacheEntry*)slot;
+        size_t j;
+        if (entry->hash != hash || entry->keySize != keySize) continue;
+        for (j = 0; j < keySize && entry->key[j] == ((const BYTE*)key)[j]; j++) {}
+        if (j != keySize) continue;
+        ZSTD_memcpy(table, entry + 1, entry->tableSize);
+        tableCacheStats[kind ? 2 : 0]++;
+        return entry->tableSize;
+    }
+    tableCacheStats[kind ? 3 : 1]++;
+    return 0;
+}
+
+static void ZSTD_wasm_tableCachePut(int kind, const void* key, size_t keySize, const void* table, size_t tableSize) {
+    TableCacheEntry* entry;
+    if (!tableCache[kind] || keySize > TABLE_CACHE_KEY_MAX || tableSize > tableCacheSizes[kind]) return;
+    entry = (TableCacheEntry*)(tableCache[kind] + tableCacheNext[kind] * TABLE_CACHE_STRIDE(kind));
+    tableCacheNext[kind] = (tableCacheNext[kind] + 1) % ZSTD_WASM_TABLE_CACHE;
+    entry->hash = tableCacheHash((const BYTE*)key, keySize);
+    entry->keySize = (U32)keySize;
+    entry->tableSize = (U32)tableSize;
+    ZSTD_memcpy(entry->key, key, keySize);
+    ZSTD_memcpy(entry + 1, table, tableSize);
+}
+#else
+static void tableCacheInit(void) {}
+#endif
+
+#ifdef __wasm__
 // Bump only. Reset in JS via pb(ptr) "prune buf"
 // Global variables do not live in the linear memory of the wasm module, ruling out overflow into the cursor.
 WASM_EXPORT
@@ -214,7 +324,7 @@ void free(void* ptr) {
     (void)ptr; // no-op
 }
 
-// This is not exported in the final binary but prevents from inline asm being "optimized" to i32.const + i32.load
+// Read by hw(). Also prevents inline asm from being "optimized" to i32.const + i32.load
 size_t get_heap_cursor(void) {
     size_t cursor;
     __asm__(
@@ -258,24 +368,133 @@ void* memset(void* s, int c, size_t n) {
 void* memmove(void* dest, const void* src, size_t n) {
     return __builtin_memmove(dest, src, n);
 }
+#else
+// Host builds keep every allocation alive, there is no shared ring buffer to prune.
+void pb(size_t new_size) {
+    (void)new_size;
+}
+#endif
+
+/*
+    Arenas: [cursor, end) ranges of linear memory, bump allocated. A mark is the cursor, releasing
+    it frees everything allocated since, so marks nest (released innermost first). Freeing the
+    last allocation gives it back too (a buffer resized in place). Allocations past end fail
+    (NULL, memory_allocation) instead of running into what follows.
+    The heap (malloc above) is the root. The stream context's arena is carved out of it by sa()
+    and set as the DCtx customMem, so ZSTD_customMalloc in ds() allocates from it. An instance
+    has a single DCtx, so a single stream arena.
+    peak is the high-water mark, for js to size memory from (hw).
+*/
+typedef struct {
+    BYTE* base;
+    BYTE* cursor;
+    BYTE* end;
+    BYTE* peak;
+    BYTE* last;
+} Arena;
+
+static void* arena_alloc(void* opaque, size_t size) {
+    Arena* const arena = (Arena*)opaque;
+    BYTE* const ptr = arena->cursor;
+    if (size > (size_t)(arena->end - ptr)) return NULL;
+    arena->cursor = ptr + size;
+    arena->last = ptr;
+    if (arena->cursor > arena->peak) arena->peak = arena->cursor;
+    return ptr;
+}
+
+// Rolls the cursor back when address is the last allocation (still live), the rest is reclaimed
+// by arena_release
+static void arena_free(void* opaque, void* address) {
+    Arena* const arena = (Arena*)opaque;
+    if ((BYTE*)address == arena->last && arena->last < arena->cursor) arena->cursor = arena->last;
+}
+
+static BYTE* arena_mark(const Arena* arena) {
+    return arena->cursor;
+}
+
+// Marks outside the arena are ignored
+static void arena_release(Arena* arena, BYTE* mark) {
+    if (mark >= arena->base && mark <= arena->end) arena->cursor = mark;
+}
+
+// Window & input buffers of the stream (ds), released by re()
+static Arena streamArena;
+
+// Sets up the stream context's arena, size bytes from the heap. Returns its base, where single
+// pass output (dS) goes too: js keeps the two apart (no dS in the middle of a stream).
+WASM_EXPORT
+void* sa(size_t size) {
+    streamArena.base = streamArena.cursor = streamArena.peak = (BYTE*)malloc(size);
+    streamArena.end = streamArena.base + size;
+    dctx->customMem.customAlloc = arena_alloc;
+    dctx->customMem.customFree = arena_free;
+    dctx->customMem.opaque = &streamArena;
+    dctx->inBuffSize = dctx->outBuffSize = 0;
+    return streamArena.base;
+}
+
+// Stream arena mark / release (checkpoint & restore)
+WASM_EXPORT
+void* am(void) {
+    return arena_mark(&streamArena);
+}
+
+WASM_EXPORT
+void ar(void* mark) {
+    arena_release(&streamArena, (BYTE*)mark);
+}
 
 // Reset Decompression Context. The bare minimum that we need.
+// Frees the previous stream's buffers: the next frame allocates them again from the arena base.
 WASM_EXPORT
 void re(void)
 {
+    arena_release(&streamArena, streamArena.base);
+    dctx->inBuffSize = dctx->outBuffSize = 0;
     dctx->streamStage = zdss_init;
     dctx->noForwardProgress = 0;
     dctx->isFrameDecompression = 1;
     dctx->format = ZSTD_f_zstd1;
 }
 
+// Largest accepted window (streaming), 8 MB + 1 for level 19 frames.
+// The small build (make small) lowers it to 1 MB + 1, in a 2 MB memory.
+#ifndef ZSTD_WASM_MAX_WINDOW_SIZE
+#define ZSTD_WASM_MAX_WINDOW_SIZE 8388609
+#endif
+
+#ifndef ZSTD_WASM_PIC
+#ifdef __wasm__
+// End of the static data, set by the linker
+extern unsigned char __heap_base;
+#endif
+
+// Heap start: 128 KB, the layout zstd-wasm.ts sizes its buffers for. Static data reaching past it
+// moves it up (16 aligned) rather than having the first allocations overwrite that data.
+static size_t heapStart(void) {
+#ifdef __wasm__
+    size_t const end = ((size_t)&__heap_base + 15) & ~(size_t)15;
+    return end > 131072 ? end : 131072;
+#else
+    return 131072;
+#endif
+}
+#endif
+
 // The ZSTD_createDctx, renamed to _initialize so the compiler understands that this is the entrypoint.
 // Those two values are the only ones that are set, the rest is zero initialized implicitly.
 // -> since we previously already reserved sufficient space for ZSTD_dctx.
+// The relocatable build (ZSTD_WASM_PIC) has no fixed heap start: js sets it with pb() first,
+// past the stack it placed after the module's data.
 void _initialize(void) {
     dctx->dictUses = ZSTD_use_indefinitely;
-    dctx->maxWindowSize = 8388609;
-    pb(131072);
+    dctx->maxWindowSize = ZSTD_WASM_MAX_WINDOW_SIZE;
+#ifndef ZSTD_WASM_PIC
+    pb(heapStart());
+#endif
+    tableCacheInit();
 }
 
 /*
@@ -378,9 +597,67 @@ static size_t dm(void* dst, size_t dstCapacity, const void* src, size_t srcSize)
 /*
     ZSTD_decompress_usingDDict > MultiFrame
 */
+/*
+    Output fingerprint: XXH3 of everything dS() / dl() write, hashed region by region right after
+    decoding, while still in cache (no second pass from js). fp(0) turns it off (default, a single
+    branch per call), fp(1) XXH3-64, fp(2) XXH3-128, and resets the running state.
+    fd() digests it into a pinned { low64, high64 }, read from js.
+    XXH3 is compiled out by zstd, ZSTD_WASM_XXH3 keeps it (patches/xxhash-xxh3.patch), without it fp()
+    returns 0: unsupported.
+*/
+static int fpMode;
+static U64 fpDigest[2];
+
+#ifdef ZSTD_WASM_XXH3
+static XXH3_state_t fpState;
+
+// XXH3-64 and XXH3-128 share the same streaming state & update
+static void fp_update(const void* ptr, size_t len) {
+    if (fpMode && len) XXH3_64bits_update(&fpState, ptr, len);
+}
+
+WASM_EXPORT
+int fp(int mode) {
+    fpMode = mode;
+    if (mode) XXH3_64bits_reset(&fpState);
+    return 1;
+}
+
+WASM_EXPORT
+U64* fd(void) {
+    if (fpMode == 2) {
+        XXH128_hash_t const h = XXH3_128bits_digest(&fpState);
+        fpDigest[0] = h.low64;
+        fpDigest[1] = h.high64;
+    } else {
+        fpDigest[0] = XXH3_64bits_digest(&fpState);
+        fpDigest[1] = 0;
+    }
+    return fpDigest;
+}
+#else
+#define fp_update(ptr, len) ((void)(ptr), (void)(len))
+
+WASM_EXPORT
+int fp(int mode) {
+    (void)mode;
+    return 0;
+}
+
+WASM_EXPORT
+U64* fd(void) {
+    return fpDigest;
+}
+#endif
+
 WASM_EXPORT
 size_t dS(void* dst, size_t dstCapacity, const void* src, size_t srcSize) {
-    return dm(dst, dstCapacity, src, srcSize);
+    size_t const result = dm(dst, dstCapacity, src, srcSize);
+    if (ZSTD_isError(result)) return result;
+    if (fpMode) fp_update(dst, result);
+    // Single pass output is written to the stream arena too
+    if ((BYTE*)dst + result > streamArena.peak) streamArena.peak = (BYTE*)dst + result;
+    return result;
 }
 
 /*
@@ -487,6 +764,8 @@ size_t ds(void) {
 
                     if (needsResize) {
                         size_t const bufferSize = neededInBuffSize + neededOutBuffSize;
+                        // Top of the stream arena, allocated again in its place
+                        if (dctx->inBuffSize) ZSTD_customFree(dctx->inBuff, dctx->customMem);
                         dctx->inBuffSize = 0;
                         dctx->outBuffSize = 0;
                         dctx->inBuff = (char*)ZSTD_customMalloc(bufferSize, dctx->customMem);
@@ -609,3 +888,181 @@ size_t ds(void) {
         return nextSrcSizeHint;
     }
 }
+
+#ifdef __wasm__
+/*
+    Host output sink (env.emit). Receives a filled region of the output staging buffer,
+    which has to be copied out before returning: it is overwritten by the next ds() call.
+*/
+__attribute__((import_module("env"), import_name("emit")))
+void emit(const void* ptr, size_t len);
+
+/*
+    Record boundaries: with a delimiter byte set through rd(), every flushed region is scanned for
+    it (16 bytes a step) right before emit(), which then finds the delimiter offsets within the
+    region in the pinned rdOut. A region holding more than RD_MAX delimiters is emitted in pieces,
+    each cut right after its last recorded delimiter. rd(-1) turns it off (default).
+    1024 offsets (4 KB) keep the static data under the 128 KB heap start.
+*/
+#define RD_MAX 1024
+
+static int rdDelim = -1;
+static struct {
+    U32 count;
+    U32 off[RD_MAX];
+} rdOut;
+
+WASM_EXPORT
+U32* rd(int delim) {
+    rdDelim = delim;
+    rdOut.count = 0;
+    return &rdOut.count;
+}
+
+// Fills rdOut from p[0, n), returns the length of the piece it covers
+static size_t rd_scan(const BYTE* p, size_t n) {
+    v128_t const d = wasm_i8x16_splat((char)rdDelim);
+    U32 count = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        U32 m = (U32)wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(p + i), d));
+        while (m) {
+            rdOut.off[count++] = (U32)i + ZSTD_countTrailingZeros32(m);
+            m &= m - 1;
+            if (count == RD_MAX) goto full;
+        }
+    }
+    for (; i < n; ++i) {
+        if (p[i] != (BYTE)rdDelim) continue;
+        rdOut.off[count++] = (U32)i;
+        if (count == RD_MAX) goto full;
+    }
+    rdOut.count = count;
+    return n;
+full:
+    rdOut.count = count;
+    return rdOut.off[count - 1] + 1;
+}
+
+// Hands the staged output to the host and rewinds the output buffer
+static void flush_out(void) {
+    if (out_buffer->pos) {
+        if (rdDelim < 0) {
+            emit(out_buffer->dst, out_buffer->pos);
+        } else {
+            const BYTE* p = (const BYTE*)out_buffer->dst;
+            for (size_t n = out_buffer->pos; n; ) {
+                size_t const len = rd_scan(p, n);
+                emit(p, len);
+                p += len;
+                n -= len;
+            }
+        }
+        out_buffer->pos = 0;
+    }
+}
+
+/*
+    Streaming loop in a single call: consumes src[0, srcSize) through ds(), flushing the output
+    buffer (set once per stream call from js) whenever flushAt bytes are staged, and what is left
+    once the last input chunk is consumed (final). One boundary crossing per flush, not per block.
+    Returns the ds() error code, or whether the stream stopped inside a frame (1) rather than on a
+    frame boundary (0): ds() holds back the last byte of a frame until its output is staged, so
+    no input left means no output left. dl(src, 0, 0, 0) only asks.
+*/
+WASM_EXPORT
+size_t dl(const void* src, size_t srcSize, size_t flushAt, int final) {
+    in_buffer->src = src;
+    in_buffer->size = srcSize;
+    in_buffer->pos = 0;
+    while (in_buffer->pos < srcSize) {
+        size_t const pos = out_buffer->pos;
+        size_t const ret = ds();
+        if (ZSTD_isError(ret)) return ret;
+        if (fpMode) fp_update((const char*)out_buffer->dst + pos, out_buffer->pos - pos);
+        if (out_buffer->pos >= flushAt) flush_out();
+    }
+    if (final) flush_out();
+    return dctx->streamStage != zdss_init;
+}
+
+/*
+    Stream checkpoint: the state a streaming decode carries between dl() calls, as the memory
+    regions holding it, listed into the pinned ckOut { count, cursor, { ptr, len }[] } for js to
+    copy out, or back in place in another instance of the same build and dictionary (same layout):
+      - the DCtx minus its per-block scratch (Huffman workspace, literal buffer): stage fields,
+        frame header, entropy tables & repeat offsets, frame checksum XXH64 state
+      - the output fingerprint XXH3 state, when on
+      - the block loaded so far into inBuff
+      - the live window in outBuff: the last windowSize bytes of the current segment (unflushed
+        output included), and the tail of the previous one once the ring buffer wrapped
+    Dictionary content is not part of it, the restoring instance loads its own. cursor is the
+    stream arena mark, set back with ar().
+*/
+#define CK_MAX 8
+
+static struct {
+    U32 count;
+    U32 cursor;
+    U32 region[CK_MAX * 2];
+} ckOut;
+
+static void ck_add(const void* ptr, size_t len) {
+    if (!len) return;
+    ckOut.region[ckOut.count * 2] = (U32)(size_t)ptr;
+    ckOut.region[ckOut.count * 2 + 1] = (U32)len;
+    ckOut.count++;
+}
+
+WASM_EXPORT
+U32* ck(void) {
+    const BYTE* const d = (const BYTE*)dctx;
+    ckOut.count = 0;
+    ckOut.cursor = (U32)(size_t)arena_mark(&streamArena);
+    ck_add(d, (size_t)((const BYTE*)dctx->workspace - d));
+    ck_add(&dctx->previousDstEnd, (size_t)(dctx->litExtraBuffer - (const BYTE*)&dctx->previousDstEnd));
+    ck_add(dctx->headerBuffer, (size_t)(d + sizeof(*dctx) - dctx->headerBuffer));
+#ifdef ZSTD_WASM_XXH3
+    if (fpMode) ck_add(&fpState, sizeof(fpState));
+#endif
+    if (dctx->streamStage != zdss_init && dctx->streamStage != zdss_loadHeader) {
+        const BYTE* const lo = (const BYTE*)dctx->outBuff;
+        const BYTE* const hi = lo + dctx->outBuffSize;
+        const BYTE* const prefix = (const BYTE*)dctx->prefixStart;
+        const BYTE* const end = (const BYTE*)dctx->previousDstEnd;
+        size_t const window = (size_t)dctx->fParams.windowSize;
+        size_t live = 0;
+        ck_add(dctx->inBuff, dctx->inPos);
+        if (prefix >= lo && end <= hi) {
+            const BYTE* start = end - MIN((size_t)(end - prefix), window);
+            if (dctx->outEnd > dctx->outStart) start = MIN(start, lo + dctx->outStart);
+            live = (size_t)(end - start);
+            ck_add(start, live);
+        }
+        // Previous segment (extDict), unless it is the dictionary
+        {   const BYTE* const dictEnd = (const BYTE*)dctx->dictEnd;
+            if (live < window && dictEnd > lo && dictEnd <= hi) {
+                size_t const len = MIN((size_t)(prefix - (const BYTE*)dctx->virtualStart), window - live);
+                ck_add(dictEnd - len, len);
+        }   }
+    }
+    return &ckOut.count;
+}
+
+/*
+    Memory high-water mark, read by js (calibration): { heap cursor, stream arena cursor, peak },
+    peak being the furthest byte of the stream arena used since the last hw(1), by stream buffers
+    or single pass output. hw(1) restarts it from the arena base, so the next frame is measured
+    on its own. The heap cursor is past the stream arena once sa() carved it.
+*/
+static U32 hwOut[3];
+
+WASM_EXPORT
+U32* hw(int reset) {
+    hwOut[0] = (U32)get_heap_cursor();
+    hwOut[1] = (U32)(size_t)streamArena.cursor;
+    hwOut[2] = (U32)(size_t)streamArena.peak;
+    if (reset) streamArena.peak = streamArena.base;
+    return hwOut;
+}
+#endif
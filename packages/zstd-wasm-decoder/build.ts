@@ -22,6 +22,10 @@ const TYPES_DIR = join(SRC_DIR, '_types');
 const BUILD_DIR = join(PKG_DIR, 'build');
 const WASM_SOURCE_PATH = join(BUILD_DIR, 'zstd.wasm');
 const WASM_PERF_PATH = join(BUILD_DIR, 'zstd-perf.wasm');
+const WASM_SMALL_PATH = join(BUILD_DIR, 'zstd-small.wasm');
+const NATIVE_PATH = join(BUILD_DIR, 'zstd-native.node');
+const WASM_PIC_PATH = join(BUILD_DIR, 'zstd-pic.wasm');
+const WASM_PIC_SHARED_PATH = join(BUILD_DIR, 'zstd-pic-shared.wasm');
 const ROOT_DIR = join(PKG_DIR, '..', '..');
 const LICENSE_PATH = join(ROOT_DIR, 'LICENSE');
 const README_PATH = join(ROOT_DIR, 'README.md');
@@ -42,8 +46,14 @@ if (!existsSync(WASM_PERF_PATH)) {
   process.exit(1);
 }
 
+if (!existsSync(WASM_SMALL_PATH)) {
+  console.error('Small window WASM file not found at:', WASM_SMALL_PATH);
+  process.exit(1);
+}
+
 console.log(`WASM size-optimized: ${(Bun.file(WASM_SOURCE_PATH).size).toLocaleString()} bytes`);
-console.log(`WASM perf-optimized: ${(Bun.file(WASM_PERF_PATH).size).toLocaleString()} bytes\n`);
+console.log(`WASM perf-optimized: ${(Bun.file(WASM_PERF_PATH).size).toLocaleString()} bytes`);
+console.log(`WASM small window: ${(Bun.file(WASM_SMALL_PATH).size).toLocaleString()} bytes\n`);
 
 const terserOptions = {
   ecma: 2020 as const,
@@ -64,7 +74,18 @@ const terserOptions = {
     reserved: ['_initialize'],
     properties: {
       regex: /^_(?!initialize)/,
-      reserved: ['_initialize'],
+      // Node stream.Transform hooks (node-stream.ts), relocatable build imports / exports (zstd-wasm.ts)
+      reserved: [
+        '_initialize',
+        '_transform',
+        '_flush',
+        '_destroy',
+        '__memory_base',
+        '__table_base',
+        '__stack_pointer',
+        '__indirect_function_table',
+        '__wasm_apply_data_relocs',
+      ],
     },
   },
   compress: {
@@ -130,6 +151,20 @@ const configs: Array<{
     target: 'browser',
     minify: true,
   },
+  {
+    name: 'Web ESM (perf)',
+    entry: join(SRC_DIR, 'index.web.perf.ts'),
+    outfile: 'index.web.perf.js',
+    target: 'browser',
+    minify: true,
+  },
+  {
+    name: 'Service Worker ESM',
+    entry: join(SRC_DIR, 'index.sw.ts'),
+    outfile: 'index.sw.js',
+    target: 'browser',
+    minify: true,
+  },
   {
     name: 'Cloudflare Workers ESM (minified)',
     entry: join(SRC_DIR, 'index.cloudflare.ts'),
@@ -145,6 +180,13 @@ const configs: Array<{
     target: 'node',
     minify: true,
   },
+  {
+    name: 'Node.js zlib shim ESM',
+    entry: join(SRC_DIR, 'index.zlib.ts'),
+    outfile: 'index.zlib.js',
+    target: 'node',
+    minify: true,
+  },
   {
     name: 'Core Library',
     entry: join(SRC_DIR, 'zstd-wasm.ts'),
@@ -281,12 +323,36 @@ await buildInlined('size');
 await buildInlined('perf');
 
 const webJs = readFileSync(join(ESM_DIR, 'index.web.js'), 'utf8');
-const webPerfJs = webJs.replace(/zstd-decoder\.wasm/g, 'zstd-decoder-perf.wasm');
-writeFileSync(join(ESM_DIR, 'index.web.perf.js'), webPerfJs);
-console.log('Built: index.web.perf.js (via string replacement)');
+
+// Small window build (1 MB windows, 2 MB memory per decoder): web & Cloudflare Workers
+writeFileSync(
+  join(ESM_DIR, 'index.web.small.js'),
+  webJs.replace(/zstd-decoder\.wasm/g, 'zstd-decoder-small.wasm'),
+);
+const cloudflareJs = readFileSync(join(ESM_DIR, 'index.cloudflare.js'), 'utf8');
+writeFileSync(
+  join(ESM_DIR, 'index.cloudflare.small.js'),
+  cloudflareJs.replace(/zstd-decoder-perf\.wasm/g, 'zstd-decoder-small.wasm'),
+);
+console.log('Built: index.web.small.js, index.cloudflare.small.js (via string replacement)');
 
 copyFileSync(WASM_SOURCE_PATH, join(ESM_DIR, 'zstd-decoder.wasm'));
 copyFileSync(WASM_PERF_PATH, join(ESM_DIR, 'zstd-decoder-perf.wasm'));
+copyFileSync(WASM_SMALL_PATH, join(ESM_DIR, 'zstd-decoder-small.wasm'));
+// Optional relocatable builds (make pic / pic-shared), for init(module, { memory, base })
+for (const [path, name] of [
+  [WASM_PIC_PATH, 'zstd-decoder-pic.wasm'],
+  [WASM_PIC_SHARED_PATH, 'zstd-decoder-pic-shared.wasm'],
+]) {
+  if (!existsSync(path)) continue;
+  copyFileSync(path, join(ESM_DIR, name));
+  console.log(`Copied: ${name}`);
+}
+// Optional, host specific (make native). Picked up by index.node.js, never published.
+if (existsSync(NATIVE_PATH)) {
+  copyFileSync(NATIVE_PATH, join(ESM_DIR, 'zstd-decoder-native.node'));
+  console.log('Copied: zstd-decoder-native.node');
+}
 try {
   execSync('tsc --project tsconfig.json', {
     cwd: PKG_DIR,
@@ -294,7 +360,7 @@ try {
     env: { ...process.env, FORCE_COLOR: '1' },
   });
 
-  const standaloneDtsFiles = ['types.d.ts', 'index.d.ts'];
+  const standaloneDtsFiles = ['types.d.ts', 'index.d.ts', 'node.d.ts'];
 
   for (const file of standaloneDtsFiles) {
     const srcPath = join(SRC_DIR, file);
@@ -0,0 +1,212 @@
+#!/usr/bin/env bun
+
+/**
+ * Compiler / wasm-opt flag search for the size & perf builds.
+ *
+ * Every configuration is a set of Makefile overrides (POLLY_FLAGS, PERF_OPT, ...). For each one
+ * the module is rebuilt through `make`, measured (raw + gzip bytes) and benchmarked over the
+ * benchmark corpus (test/benchmark/compressed, see `pnpm run bench:setup`).
+ *
+ * Results are written to build/flag-search/results.json, followed by the Pareto frontier
+ * (throughput vs. gzipped bytes) and the best configuration per target.
+ *
+ *   bun flag-search.ts                      # both targets, full grid
+ *   bun flag-search.ts --target perf        # perf build only
+ *   bun flag-search.ts --sample 12          # random subset of the grid
+ *   bun flag-search.ts --rounds 10          # benchmark rounds per configuration
+ */
+
+import { spawnSync } from 'node:child_process';
+import { existsSync, mkdirSync, readdirSync, readFileSync, writeFileSync } from 'node:fs';
+import { join } from 'node:path';
+import { gzipSync, zstdDecompressSync } from 'node:zlib';
+import { ZstdDecoder } from './src/zstd-wasm.ts';
+
+const PKG_DIR = import.meta.dir;
+const SEARCH_DIR = join(PKG_DIR, 'build', 'flag-search');
+const CORPUS_DIR = join(PKG_DIR, '..', '..', 'test', 'benchmark', 'compressed');
+
+const arg = (name: string, fallback: string) => {
+  const idx = process.argv.indexOf(`--${name}`);
+  return idx > -1 && process.argv[idx + 1] ? process.argv[idx + 1] : fallback;
+};
+
+const TARGETS = (
+  arg('target', 'both') === 'both' ? ['size', 'perf'] : [arg('target', 'perf')]
+) as Array<'size' | 'perf'>;
+const ROUNDS = parseInt(arg('rounds', '5'), 10);
+const SAMPLE = parseInt(arg('sample', '0'), 10);
+
+/**
+ * Search space. Each dimension maps a label to the Makefile overrides it implies;
+ * the first entry of every dimension is the current Makefile default (no override).
+ */
+const DIMENSIONS = (
+  target: 'size' | 'perf',
+): Record<string, Record<string, Record<string, string>>> => ({
+  clang:
+    target === 'size'
+      ? { Oz: {}, Os: { SIZE_OPT: '-Os' } }
+      : { Os: {}, O2: { PERF_OPT: '-O2' }, O3: { PERF_OPT: '-O3' } },
+  polly: { on: {}, off: { POLLY_FLAGS: '' } },
+  seqs: { fused: {}, twopass: { SEQ_FLAGS: '-DZSTD_WASM_TWO_PASS_SEQUENCES' } },
+  mono: { on: {}, off: { WASM_OPT_MONOMORPHIZE: '' } },
+  extra: { on: {}, off: { WASM_OPT_FLAGS_EXTRA: '' } },
+  wasmopt:
+    target === 'size'
+      ? { Oz: {}, Os: { WASM_OPT_SIZE_LEVEL: '-Os' } }
+      : { Os: {}, O3: { WASM_OPT_PERF_LEVEL: '-O3' }, O4: { WASM_OPT_PERF_LEVEL: '-O4' } },
+});
+
+interface Result {
+  target: 'size' | 'perf';
+  id: string;
+  overrides: Record<string, string>;
+  bytes: number;
+  gzBytes: number;
+  mbps: number;
+}
+
+const expand = (dims: Record<string, Record<string, Record<string, string>>>) => {
+  let configs: Array<{ id: string[]; overrides: Record<string, string> }> = [
+    { id: [], overrides: {} },
+  ];
+  for (const [dim, values] of Object.entries(dims)) {
+    configs = configs.flatMap((c) =>
+      Object.entries(values).map(([label, o]) => ({
+        id: [...c.id, `${dim}=${label}`],
+        overrides: { ...c.overrides, ...o },
+      })),
+    );
+  }
+  return configs.map((c) => ({ id: c.id.join(','), overrides: c.overrides }));
+};
+
+const loadCorpus = () => {
+  if (!existsSync(CORPUS_DIR)) {
+    console.error(`No benchmark corpus at ${CORPUS_DIR} (run: pnpm run bench:setup)`);
+    process.exit(1);
+  }
+  const buffers = readdirSync(CORPUS_DIR)
+    .filter((f) => f.endsWith('.zst'))
+    .map((f) => new Uint8Array(readFileSync(join(CORPUS_DIR, f))));
+  const totalMB = buffers.reduce((sum, b) => sum + zstdDecompressSync(b).length, 0) / 1024 / 1024;
+  return { buffers, totalMB };
+};
+
+const build = (target: 'size' | 'perf', id: string, overrides: Record<string, string>) => {
+  const out = join(SEARCH_DIR, `${target}-${id.replace(/[=,]/g, '_')}.wasm`);
+  const result = spawnSync(
+    'make',
+    [
+      target,
+      `${target === 'size' ? 'OUTPUT' : 'OUTPUT_PERF'}=${out}`,
+      ...Object.entries(overrides).map(([k, v]) => `${k}=${v}`),
+    ],
+    { cwd: PKG_DIR, stdio: ['ignore', 'ignore', 'inherit'] },
+  );
+  if (result.status !== 0) throw new Error(`make ${target} failed for ${id}`);
+  return readFileSync(out);
+};
+
+const bench = (wasm: Uint8Array, buffers: Uint8Array[], totalMB: number) => {
+  const decoder = new ZstdDecoder().init(new WebAssembly.Module(wasm));
+  for (const buf of buffers) decoder.decompressSync(buf);
+
+  let best = 0;
+  for (let r = 0; r < ROUNDS; ++r) {
+    const start = performance.now();
+    for (const buf of buffers) decoder.decompressSync(buf);
+    best = Math.max(best, totalMB / ((performance.now() - start) / 1000));
+  }
+  decoder._destroy();
+  return best;
+};
+
+// Lower gz bytes & higher MB/s is better
+const pareto = (results: Result[]) =>
+  results
+    .filter(
+      (a) =>
+        !results.some(
+          (b) =>
+            b !== a &&
+            b.gzBytes <= a.gzBytes &&
+            b.mbps >= a.mbps &&
+            (b.gzBytes < a.gzBytes || b.mbps > a.mbps),
+        ),
+    )
+    .sort((a, b) => a.gzBytes - b.gzBytes);
+
+const makeLine = (r: Result) =>
+  `make ${r.target} ${Object.entries(r.overrides)
+    .map(([k, v]) => `${k}='${v}'`)
+    .join(' ')}`.trim();
+
+const print = (rows: Result[]) => {
+  for (const r of rows) {
+    console.log(
+      `${r.target.padEnd(5)} ${r.id.padEnd(60)} ${r.bytes.toLocaleString().padStart(9)} b ${r.gzBytes
+        .toLocaleString()
+        .padStart(8)} gz ${r.mbps.toFixed(2).padStart(9)} MB/s`,
+    );
+  }
+};
+
+if (!existsSync(SEARCH_DIR)) mkdirSync(SEARCH_DIR, { recursive: true });
+
+const { buffers, totalMB } = loadCorpus();
+console.log(`Corpus: ${buffers.length} files, ${totalMB.toFixed(2)} MB decompressed\n`);
+
+const results: Result[] = [];
+for (const target of TARGETS) {
+  let configs = expand(DIMENSIONS(target));
+  if (SAMPLE > 0 && SAMPLE < configs.length) {
+    // Always keep the current default (first) as the baseline
+    const [baseline, ...rest] = configs;
+    configs = [baseline, ...rest.sort(() => Math.random() - 0.5).slice(0, SAMPLE - 1)];
+  }
+
+  for (const [i, { id, overrides }] of configs.entries()) {
+    process.stdout.write(`\r[${target} ${i + 1}/${configs.length}] ${id}`.padEnd(90));
+    try {
+      const wasm = build(target, id, overrides);
+      results.push({
+        target,
+        id,
+        overrides,
+        bytes: wasm.length,
+        gzBytes: gzipSync(wasm, { level: 9 }).length,
+        mbps: bench(wasm, buffers, totalMB),
+      });
+    } catch (error) {
+      console.error(`\n${error}`);
+    }
+  }
+  console.log('');
+}
+
+writeFileSync(join(SEARCH_DIR, 'results.json'), JSON.stringify(results, null, 2));
+
+for (const target of TARGETS) {
+  const rows = results.filter((r) => r.target === target);
+  if (!rows.length) continue;
+  const baseline = rows[0];
+  const frontier = pareto(rows);
+  const best =
+    target === 'size'
+      ? rows.reduce((a, b) =>
+          b.gzBytes < a.gzBytes || (b.gzBytes === a.gzBytes && b.mbps > a.mbps) ? b : a,
+        )
+      : rows.reduce((a, b) => (b.mbps > a.mbps ? b : a));
+
+  console.log(`\n${'='.repeat(50)}\n${target}: Pareto frontier (gz bytes vs MB/s)\n${'='.repeat(50)}`);
+  print(frontier);
+  console.log('\nBaseline (current Makefile):');
+  print([baseline]);
+  console.log(`\nBest for ${target}:`);
+  print([best]);
+  console.log(`  ${makeLine(best)}`);
+}
+
+console.log(`\nResults: ${join(SEARCH_DIR, 'results.json')}`);
@@ -0,0 +1,296 @@
+import {
+  _acquireDecoder,
+  _getDictId,
+  _HEADER_MAX,
+  _internal,
+  _releaseDecoder,
+  type _DecoderPool,
+  type ZstdDecoder,
+} from './shared.js';
+import type { ZstdOptions } from './types.js';
+import { _concatUint8Arrays, err } from './utils.js';
+
+/**
+ * Cloudflare Workers decoder pool.
+ *
+ * An isolate serves many concurrent requests and is limited to 128 MB, each wasm instance
+ * holds its full (fixed) memory: 16 MB, or 2 MB for the small window build. Decoders are
+ * therefore capped by a memory budget and kept for the lifetime of the isolate. Requests
+ * lease them, and wait for a release once the budget is used instead of instantiating more.
+ * Free decoders of another dictionary are re-created for the requested one.
+ */
+
+/**
+ * Pool configuration, see {@link setupCloudflarePool}
+ */
+export interface CloudflarePoolOptions {
+  /** Wasm memory the pool may hold, in bytes (default: 64 MB, half the isolate limit) */
+  memoryBudget?: number;
+}
+
+/**
+ * Pool occupancy, see {@link getPoolStats}
+ */
+export interface PoolStats {
+  /** Decoders the budget allows */
+  max: number;
+  /** Live decoders */
+  size: number;
+  /** Currently leased */
+  leased: number;
+  /** Acquisitions waiting for a release */
+  waiting: number;
+  /** Wasm memory per decoder, 0 until the first one is created */
+  instanceMemory: number;
+}
+
+/**
+ * A request-scoped decoder. Release it once done, repeated calls are no-ops.
+ */
+export interface DecoderLease {
+  readonly decoder: ZstdDecoder;
+  release(): void;
+}
+
+interface _Slot {
+  decoder: ZstdDecoder | null;
+  dictId: number;
+  leased: boolean;
+}
+
+const _DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+export class WorkersDecoderPool implements _DecoderPool {
+  private readonly _slots: _Slot[] = [];
+  private readonly _waiters: (() => void)[] = [];
+  private _budget: number;
+  private _instanceMemory = 0;
+
+  constructor(options: CloudflarePoolOptions = {}) {
+    this._budget = options.memoryBudget || _DEFAULT_BUDGET;
+  }
+
+  configure(options: CloudflarePoolOptions): void {
+    if (options.memoryBudget) this._budget = options.memoryBudget;
+    this._wake();
+  }
+
+  private get _max(): number {
+    // Until the first instance tells its size, allow one
+    return this._instanceMemory ? Math.max(1, Math.floor(this._budget / this._instanceMemory)) : 1;
+  }
+
+  private _lease(slot: _Slot, idx: number): [ZstdDecoder, number] {
+    slot.leased = true;
+    return [slot.decoder!, idx];
+  }
+
+  // The old decoder goes first, the budget has no room for both. A slot left empty by a failed
+  // create (bad dictionary, out of memory) matches no dictionary: the next acquire refills it,
+  // a waiter is woken for it
+  private _create(slot: _Slot, dictId: number, create: () => ZstdDecoder): ZstdDecoder {
+    slot.decoder?._destroy();
+    slot.decoder = null;
+    slot.dictId = -1;
+    try {
+      slot.decoder = create();
+    } catch (error) {
+      this._wake();
+      throw error;
+    }
+    slot.dictId = dictId;
+    this._instanceMemory ||= slot.decoder._memorySize();
+    return slot.decoder;
+  }
+
+  // Free decoder for dictId, a new one within the budget, or a free one of another dictionary
+  private _tryAcquire(dictId: number, create: () => ZstdDecoder): [ZstdDecoder, number] | null {
+    const slots = this._slots;
+    let other = -1;
+    for (let i = 0; i < slots.length; ++i) {
+      if (slots[i].leased) continue;
+      if (slots[i].dictId == dictId) return this._lease(slots[i], i);
+      other = i;
+    }
+    if (slots.length < this._max) {
+      const slot: _Slot = { decoder: null, dictId, leased: false };
+      slots.push(slot);
+      try {
+        this._create(slot, dictId, create);
+      } catch (error) {
+        slots.pop();
+        throw error;
+      }
+      return this._lease(slot, slots.length - 1);
+    }
+    if (other != -1) {
+      this._create(slots[other], dictId, create);
+      return this._lease(slots[other], other);
+    }
+    return null;
+  }
+
+  async acquire(dictId: number, create: () => ZstdDecoder): Promise<[ZstdDecoder, number]> {
+    for (;;) {
+      const leased = this._tryAcquire(dictId, create);
+      if (leased) return leased;
+      await new Promise<void>((resolve) => this._waiters.push(resolve));
+    }
+  }
+
+  // Synchronous callers cannot wait: above the budget they get an ephemeral decoder
+  acquireSync(dictId: number, create: () => ZstdDecoder): [ZstdDecoder, number] {
+    return this._tryAcquire(dictId, create) || [create(), -1];
+  }
+
+  release(idx: number): void {
+    const slot = this._slots[idx];
+    if (!slot?.leased) return;
+    slot.leased = false;
+    this._wake();
+  }
+
+  // As many waiters as there are free slots, and room for new ones within the budget
+  private _wake(): void {
+    let free = this._max - this._slots.length;
+    for (const slot of this._slots) free += +!slot.leased;
+    for (; free > 0 && this._waiters.length; --free) this._waiters.shift()!();
+  }
+
+  stats(): PoolStats {
+    return {
+      max: this._max,
+      size: this._slots.length,
+      leased: this._slots.reduce((n, slot) => n + +slot.leased, 0),
+      waiting: this._waiters.length,
+      instanceMemory: this._instanceMemory,
+    };
+  }
+}
+
+const pool = new WorkersDecoderPool();
+
+export const _installPool = (): void => {
+  _internal._pool = pool;
+};
+
+/**
+ * Sets the memory budget of the isolate wide decoder pool
+ */
+export const setupCloudflarePool = /*! @__PURE__ */ (options: CloudflarePoolOptions): void =>
+  pool.configure(options);
+
+/**
+ * Pool occupancy snapshot
+ */
+export const getPoolStats = /*! @__PURE__ */ (): PoolStats => pool.stats();
+
+/**
+ * Leases a pooled decoder, waiting for a release when the budget is used.
+ *
+ * ```js
+ * const lease = await acquireDecoder();
+ * try {
+ *   return new Response(lease.decoder.decompressSync(body));
+ * } finally {
+ *   lease.release();
+ * }
+ * ```
+ */
+export const acquireDecoder = /*! @__PURE__ */ async (
+  options?: ZstdOptions & { dictId?: number },
+): Promise<DecoderLease> => {
+  const [decoder, idx, dictId] = await _acquireDecoder(options?.dictId || 0, options);
+  let released = false;
+  return {
+    decoder,
+    release() {
+      if (released) return;
+      released = true;
+      idx == -1 ? decoder._destroy() : _releaseDecoder(idx, dictId);
+    },
+  };
+};
+
+/**
+ * Decompresses a zstd response body as a stream. The decoder is leased on the first read,
+ * and released when the body is fully read, fails, or is canceled (client gone).
+ *
+ * ```js
+ * export default {
+ *   async fetch(request) {
+ *     return decompressResponse(await fetch(upstream, request));
+ *   },
+ * };
+ * ```
+ */
+export const decompressResponse = /*! @__PURE__ */ (
+  response: Response,
+  options?: ZstdOptions,
+): Response => {
+  const headers = new Headers(response.headers);
+  headers.delete('content-encoding');
+  headers.delete('content-length');
+  const init = { status: response.status, statusText: response.statusText, headers };
+  if (!response.body) return new Response(null, init);
+
+  const reader = response.body.getReader();
+  let lease: DecoderLease | null = null;
+  let pending: Uint8Array[] = [];
+  let pendingLen = 0;
+
+  const release = () => {
+    lease?.release();
+    lease = null;
+  };
+
+  const body = new ReadableStream<Uint8Array>({
+    // Reads until some output was produced: a pull that enqueues nothing is not repeated
+    async pull(controller) {
+      let produced = false;
+      const enqueue = (chunk: Uint8Array) => {
+        produced = true;
+        controller.enqueue(chunk);
+      };
+      try {
+        while (!produced) {
+          const { done, value } = await reader.read();
+          if (!done) {
+            if (lease) {
+              lease.decoder.decompressStream(value, false, enqueue);
+              continue;
+            }
+            // Hold back until the frame header (dictionary ID) is complete
+            pending.push(value);
+            pendingLen += value.length;
+            if (pendingLen < _HEADER_MAX) continue;
+          }
+          if (!lease && pendingLen) {
+            const input = _concatUint8Arrays(pending, pendingLen);
+            pending = [];
+            pendingLen = 0;
+            lease = await acquireDecoder({ ...options, dictId: _getDictId(input) });
+            lease.decoder.decompressStream(input, true, enqueue);
+          }
+          if (done) {
+            // Body cut inside a frame
+            if (lease?.decoder._midFrame()) throw new err('unexpected end of file');
+            release();
+            controller.close();
+            return;
+          }
+        }
+      } catch (error) {
+        release();
+        reader.cancel(error).catch(() => {});
+        controller.error(error);
+      }
+    },
+    cancel(reason) {
+      release();
+      return reader.cancel(reason);
+    },
+  });
+
+  return new Response(body, init);
+};
@@ -1,21 +1,47 @@
-import { _internal, _pushToPool, ZstdDecoder } from './shared.js';
+import { _installPool } from './cloudflare-pool.js';
+import { _internal } from './shared.js';
 //@ts-expect-error
 import wasmModule from './zstd-decoder-perf.wasm';
 
 // biome-ignore lint/performance/noBarrelFile: entrypoint module
 export {
+  calibrateMemory,
   createDecoder,
+  decodeRecords,
   decompress,
   decompressStream,
   decompressSync,
+  decompressToString,
+  getResultCacheStats,
+  setupResultCache,
   setupZstdDecoder,
   ZstdDecoder,
   ZstdDecompressionStream,
 } from './shared.js';
 
-export type { DecoderOptions, StreamResult } from './types.js';
+export { decodeZstdResponse } from './response.js';
+export { TarZstReader } from './tar.js';
+export type { TarEntry, TarEntryType, TarHeader, TarZstOptions } from './tar.js';
 
-let initialized = false;
+export {
+  acquireDecoder,
+  decompressResponse,
+  getPoolStats,
+  setupCloudflarePool,
+  WorkersDecoderPool,
+} from './cloudflare-pool.js';
+
+export type {
+  DecoderMemory,
+  DecoderOptions,
+  MemoryCalibration,
+  ResultCacheOptions,
+  ResultCacheStats,
+  StreamResult,
+  TableCacheStats,
+  ZstdRecordOptions,
+} from './types.js';
+export type { CloudflarePoolOptions, DecoderLease, PoolStats } from './cloudflare-pool.js';
 
 /**
  * Example usage:
@@ -40,17 +66,12 @@ let initialized = false;
  *   result += value;
  * }
  * console.log(result);
+ *
+ * // Or release the pooled decoder as soon as the client is gone
+ * return decompressResponse(await fetch("https://example.com/data.zst"));
  * ```
  */
-_internal._loader = async () => {
-  const instance = new WebAssembly.Instance(wasmModule, { env: {} });
-
-  if (!initialized) {
-    const decoder = new ZstdDecoder(_internal.buffer);
-    decoder._initWithInstance(instance, wasmModule);
-    _pushToPool(decoder, wasmModule, 0);
-    initialized = true;
-  }
-
-  return wasmModule;
-};
+// The module is compiled at deploy time: nothing to load. Instances are created by the
+// isolate wide pool, within its memory budget (setupCloudflarePool), and reused across requests.
+_internal._loader = () => wasmModule;
+_installPool();
@@ -1,4 +1,6 @@
+import type { TarEntry, TarZstOptions } from './tar.js';
 export type { BaseWasmExports, DecoderWasmExports } from './types.js';
+export type { TarEntry, TarEntryType, TarHeader, TarZstOptions } from './tar.js';
 
 /**
  * Web Streams API transform for Zstandard decompression.
@@ -26,7 +28,7 @@ export type { BaseWasmExports, DecoderWasmExports } from './types.js';
 export declare class ZstdDecompressionStream {
   /**
    * The resulting decompressed stream to read output from.
-   * @type {ReadableStream<Uint8Array>}
+   * @type {ReadableStream<Uint8Array>} (strings with `output: 'text'`)
    */
   readonly readable: ReadableStream;
   /**
@@ -36,9 +38,10 @@ export declare class ZstdDecompressionStream {
   readonly writable: WritableStream;
 
   /**
-   * @param {ZstdOptions} [options] - Optional decoder configuration.
+   * @param {ZstdStreamOptions} [options] - Optional decoder configuration, `worker: true` decodes ahead in a worker,
+   * `output: 'text'` yields strings.
    */
-  constructor(options?: ZstdOptions);
+  constructor(options?: ZstdStreamOptions);
 }
 
 /**
@@ -87,6 +90,66 @@ export declare function decompressStream(
   options?: ZstdOptions,
 ): Promise<StreamResult>;
 
+/**
+ * Decompress a Zstandard-compressed buffer synchronously to a string. The output is UTF-8
+ * decoded directly from wasm memory (streamed with `TextDecoder` when the frame has no content
+ * size), without the intermediate `Uint8Array` of {@link decompressSync}.
+ *
+ * @example
+ * const json = JSON.parse(decompressToString(compressed));
+ */
+export declare function decompressToString(input: Uint8Array, options?: ZstdOptions): string;
+
+/**
+ * Decompresses a stream into records split on a delimiter byte (newline by default, NDJSON).
+ * The delimiter is found by the decoder while flushing output, without a scan in js. Yields
+ * the records completed by each input chunk, views into the output where possible; records
+ * straddling two output chunks are carried over and joined.
+ *
+ * @example
+ * for await (const records of decodeRecords(response.body!)) {
+ *   for (const record of records) handle(JSON.parse(textDecoder.decode(record)));
+ * }
+ */
+export declare function decodeRecords(
+  stream: ReadableStream<BufferSource> | AsyncIterable<BufferSource>,
+  options?: ZstdRecordOptions,
+): AsyncGenerator<Uint8Array[]>;
+
+/**
+ * Streaming `.tar.zst` reader. Entries are yielded as the archive is decoded; tar headers are
+ * parsed from views of wasm memory, and the bodies of entries that are filtered out or left
+ * unread are dropped without being copied to js. GNU long names and pax records are applied.
+ *
+ * @example
+ * for await (const entry of new TarZstReader(response.body!, { filter: (h) => h.name.endsWith('.json') })) {
+ *   const json = JSON.parse(await entry.text());
+ * }
+ */
+export declare class TarZstReader implements AsyncIterable<TarEntry> {
+  constructor(
+    stream: ReadableStream<BufferSource> | AsyncIterable<BufferSource>,
+    options?: TarZstOptions,
+  );
+  [Symbol.asyncIterator](): AsyncGenerator<TarEntry>;
+  /** Entries in archive order, the archive can only be read once */
+  entries(): AsyncGenerator<TarEntry>;
+}
+
+/**
+ * Decodes a fetch() Response holding zstd (`.zst` assets, or `Content-Encoding: zstd` bodies the
+ * runtime did not decode), streamed chunk by chunk as it arrives. Responses that are not zstd,
+ * checked on their first bytes, are returned as is. `.zst` assets get the content type of the
+ * name under `.zst` when known. Used by the `zstd-wasm-decoder/service-worker` entry.
+ *
+ * @example
+ * const data = await (await decodeZstdResponse(await fetch('/data/app.json.zst'))).json();
+ */
+export declare function decodeZstdResponse(
+  response: Response,
+  options?: ZstdOptions,
+): Promise<Response>;
+
 /**
  * Decompress a Zstandard-compressed buffer synchronously.
  *
@@ -120,7 +183,67 @@ export declare function decompressSync(
  * @param options - Decoder configuration options (dictionary, WASM path, limits).
  * @returns A promise that resolves to an initialized decoder instance.
  */
-export declare function createDecoder(options?: ZstdOptions): Promise<ZstdDecoder>;
+export declare function createDecoder(
+  options?: ZstdOptions & Pick<DecoderOptions, 'fingerprint'>,
+): Promise<ZstdDecoder>;
+
+/**
+ * Measures the memory the workload needs: decodes the samples in a fresh wasm instance and
+ * records the memory high-water mark per window size.
+ *
+ * @param samples - Compressed frames representative of the workload.
+ * @returns Limits for {@link setupZstdDecoder}, the region size for the relocatable build and
+ * whether the small window build fits (can be persisted as JSON).
+ *
+ * @example
+ * const calibration = await calibrateMemory(samples);
+ * await setupZstdDecoder(calibration); // maxSrcSize & maxDstSize
+ * const decoder = new ZstdDecoder().init(pic, { memory, base, size: calibration.memorySize });
+ */
+export declare function calibrateMemory(samples: Uint8Array[]): Promise<MemoryCalibration>;
+
+/**
+ * Opts into hybrid dispatch between wasm and the runtime's native zstd (Node, Bun).
+ *
+ * {@link decompressSync} and {@link decompress} are then routed per input size class from a
+ * routing table measured at setup, or from a persisted one. Only complete single frames are
+ * routed natively; any native failure is replayed on wasm, so errors and limits stay the same.
+ * Without a native zstd in the runtime everything stays on wasm and `null` is returned.
+ *
+ * @param options.calibration - Previously returned calibration, reused if the provider matches.
+ * @param options.samples - Compressed inputs representative of the workload, to calibrate on.
+ * @returns The routing table in use (can be persisted as JSON).
+ *
+ * @example
+ * const calibration = await setupHybridDecoder({ calibration: JSON.parse(stored) });
+ * const data = decompressSync(compressed); // wasm or native, by size class
+ */
+export declare function setupHybridDecoder(options?: {
+  calibration?: HybridCalibration;
+  samples?: Uint8Array[];
+}): Promise<HybridCalibration | null>;
+
+/**
+ * Routing decisions of the hybrid dispatcher since {@link setupHybridDecoder}.
+ */
+export declare function getHybridMetrics(): HybridMetrics;
+
+/**
+ * Opt into the decompressed result cache of {@link decompress} / {@link decompressSync}.
+ * Byte-identical inputs with the same dictionary ID are answered from an LRU cache bounded by
+ * `maxBytes`, without decoding (a copy of the cached output, or the output itself with
+ * `shared: true`). Resets the counters, `maxBytes: 0` disables & clears the cache.
+ *
+ * @example
+ * setupResultCache({ maxBytes: 32 * 1024 * 1024 });
+ * const snapshot = decompressSync(message); // repeats of message are cache hits
+ */
+export declare function setupResultCache(options: ResultCacheOptions): void;
+
+/**
+ * Result cache hits, misses & occupancy since {@link setupResultCache}.
+ */
+export declare function getResultCacheStats(): ResultCacheStats;
 
 /**
  * Low-level ZSTD decoder class.
@@ -145,9 +268,11 @@ export declare class ZstdDecoder {
    * Initializes the decoder with a WebAssembly module.
    *
    * @param wasmModule - Compiled WebAssembly module
+   * @param region - Host owned memory region, for the relocatable build (`make pic`): the decoder
+   * runs in `[base, base + size)` of that memory instead of its own
    * @returns Promise that resolves to the initialized decoder
    */
-  init(wasmModule?: WebAssembly.Module): Promise<ZstdDecoder>;
+  init(wasmModule?: WebAssembly.Module, region?: DecoderMemory): Promise<ZstdDecoder>;
 
   /**
    * Decompresses data using the low-level streaming API.
@@ -157,9 +282,38 @@ export declare class ZstdDecoder {
    *
    * @param data - ZSTD compressed data chunk.
    * @param reset - Whether to reset the decompression context for a new stream.
+   * @param emit - Optional sink for each flushed output slice; `buf` is then left empty.
+   * With a {@link recordDelimiter}, it also receives the delimiter offsets within the slice.
    * @returns Stream result with decompressed buffer and input offset metadata.
    */
-  decompressStream(data: Uint8Array, reset?: boolean): StreamResult;
+  decompressStream(
+    data: Uint8Array,
+    reset?: boolean,
+    emit?: (chunk: Uint8Array, records?: Uint32Array) => void,
+  ): StreamResult;
+
+  /**
+   * Scans the output flushed to the `emit` sink of decompressStream for a delimiter byte,
+   * in wasm with SIMD. No argument turns it off.
+   */
+  recordDelimiter(byte?: number): void;
+
+  /**
+   * Same as decompressSync, returning a view of the decoder's output area instead of a copy,
+   * valid until the next call on this decoder.
+   */
+  decompressView(data: Uint8Array, expectedSize?: number): Uint8Array;
+
+  /**
+   * The decoder's input area: compressed data read into its start and passed to decompressSync /
+   * decompressView as a view of it is not copied again.
+   */
+  inputBuffer(): Uint8Array;
+
+  /**
+   * Same as decompressSync, UTF-8 decoded straight from wasm memory.
+   */
+  decompressToString(data: Uint8Array, expectedSize?: number): string;
 
   /**
    * Decompresses data synchronously.
@@ -170,6 +324,31 @@ export declare class ZstdDecoder {
    */
   decompressSync(data: Uint8Array, expectedSize?: number): Uint8Array;
 
+  /**
+   * Entropy table cache counters of this instance. Streams of small frames sharing
+   * Huffman / FSE headers reuse the tables built for earlier frames.
+   */
+  tableCacheStats(): TableCacheStats;
+
+  /**
+   * XXH3 of the output of the last decompressSync, or of the current decompressStream stream
+   * so far, hashed in wasm while decoding. Requires the `fingerprint` option.
+   */
+  fingerprint(): bigint;
+
+  /**
+   * Snapshot of the current decompressStream stream (decoding context, entropy tables, repeat
+   * offsets, checksum state & live window, about windowSize + 28 KB), to resume it in another
+   * decoder of the same build, dictionary & options, e.g. in another worker.
+   */
+  checkpoint(): Uint8Array;
+
+  /**
+   * Resumes the stream of a {@link ZstdDecoder.checkpoint}: the next decompressStream call
+   * (reset false) continues where the checkpointed decoder stopped.
+   */
+  restore(snapshot: Uint8Array): void;
+
   /**
    * Cleans up decoder resources and detaches references to the underlying
    * WASM memory. After calling this, the instance must not be used again.
@@ -177,7 +356,20 @@ export declare class ZstdDecoder {
   _destroy(): void;
 }
 
-export type { DecoderOptions, StreamResult, ZstdOptions };
+export type {
+  DecoderMemory,
+  DecoderOptions,
+  HybridCalibration,
+  HybridMetrics,
+  MemoryCalibration,
+  ResultCacheOptions,
+  ResultCacheStats,
+  StreamResult,
+  TableCacheStats,
+  ZstdOptions,
+  ZstdRecordOptions,
+  ZstdStreamOptions,
+};
 
 declare const _default: {
   createDecoder: typeof createDecoder;
@@ -1,20 +1,123 @@
 import { readFileSync } from 'node:fs';
-import { _internal } from './shared.js';
+import { createRequire } from 'node:module';
+import { isMainThread, parentPort, Worker, workerData } from 'node:worker_threads';
+import * as zlib from 'node:zlib';
+import { _internal, type ZstdDecoder } from './shared.js';
+import {
+  _installStreamWorker,
+  _STREAM_WORKER,
+  _serveStream,
+  type _WorkerHandle,
+} from './stream-worker.js';
+import { type NativeBinding, ZstdNativeDecoder } from './zstd-native.js';
 
 // biome-ignore lint/performance/noBarrelFile: entrypoint module
 export {
+  calibrateMemory,
   createDecoder,
+  decodeRecords,
   decompress,
   decompressStream,
   decompressSync,
+  decompressToString,
+  getHybridMetrics,
+  setupHybridDecoder,
+  getResultCacheStats,
+  setupResultCache,
   setupZstdDecoder,
   ZstdDecoder,
   ZstdDecompressionStream,
 } from './shared.js';
 
-export type { DecoderOptions, StreamResult } from './types.js';
+export { decodeZstdResponse } from './response.js';
+export { TarZstReader } from './tar.js';
+export type { TarEntry, TarEntryType, TarHeader, TarZstOptions } from './tar.js';
+
+export { createZstdDecompress, ZstdDecompress } from './node-stream.js';
+export type { ZstdDecompressOptions } from './node-stream.js';
+
+export type {
+  DecoderMemory,
+  DecoderOptions,
+  HybridCalibration,
+  HybridMetrics,
+  MemoryCalibration,
+  ResultCacheOptions,
+  ResultCacheStats,
+  StreamResult,
+  TableCacheStats,
+  ZstdRecordOptions,
+  ZstdStreamOptions,
+} from './types.js';
 
 _internal._loader = () => {
   const wasmUrl = new URL('./zstd-decoder-perf.wasm', import.meta.url);
   return new WebAssembly.Module(readFileSync(wasmUrl));
 };
+
+// Native addon (`make native`), copied next to the wasm by build.ts when it was built.
+// ZSTD_DECODER_NATIVE=0 forces wasm, any other value is the path of the .node file to load.
+const _addon = (): NativeBinding | null => {
+  const env = process.env.ZSTD_DECODER_NATIVE;
+  if (env === '0') return null;
+  try {
+    return createRequire(import.meta.url)(env || './zstd-decoder-native.node');
+  } catch {
+    return null;
+  }
+};
+
+const binding = _addon();
+if (binding) {
+  _internal._factory = (options) =>
+    new ZstdNativeDecoder(options).init(binding) as unknown as ZstdDecoder;
+}
+
+// Runtime native zstd for setupHybridDecoder: Bun, or node:zlib (Node >= 22.15)
+const _bun = (globalThis as any).Bun;
+if (_bun?.zstdDecompressSync) {
+  _internal._native = {
+    name: 'bun',
+    dict: false,
+    sync: (input) => _bun.zstdDecompressSync(input),
+    async: (input) => _bun.zstdDecompress(input),
+    compress: (input) => _bun.zstdCompressSync(input),
+  };
+} else if (zlib.zstdDecompressSync) {
+  _internal._native = {
+    name: 'node:zlib',
+    dict: true,
+    sync: (input, maxOutputLength, dictionary) =>
+      zlib.zstdDecompressSync(input, { maxOutputLength, dictionary }),
+    async: (input, maxOutputLength, dictionary) =>
+      new Promise((resolve, reject) =>
+        zlib.zstdDecompress(input, { maxOutputLength, dictionary }, (error, result) =>
+          error ? reject(error) : resolve(result),
+        ),
+      ),
+    compress: (input) => zlib.zstdCompressSync(input),
+  };
+}
+
+// ZstdDecompressionStream({ worker: true }): this module again, on a worker thread
+
+_installStreamWorker((): _WorkerHandle => {
+  const worker = new Worker(new URL(import.meta.url), { workerData: _STREAM_WORKER });
+  const handle: _WorkerHandle = {
+    post: (message, transfer) => worker.postMessage(message, transfer as ArrayBuffer[]),
+    busy: (on) => (on ? worker.ref() : worker.unref()),
+    terminate: () => void worker.terminate(),
+    onmessage: () => {},
+  };
+  worker.on('message', (message) => handle.onmessage(message));
+  worker.on('error', (error) => handle.onmessage(error));
+  worker.on('exit', (code) => handle.onmessage(new Error(`zstd worker exited with code ${code}`)));
+  return handle;
+});
+
+if (!isMainThread && workerData === _STREAM_WORKER) {
+  parentPort!.on(
+    'message',
+    _serveStream((message, transfer) => parentPort!.postMessage(message, transfer as ArrayBuffer[])),
+  );
+}
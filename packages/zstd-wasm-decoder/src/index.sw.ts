@@ -0,0 +1,46 @@
+/**
+ * `zstd-wasm-decoder/service-worker`: transparent zstd for fetch responses, in a module
+ * Service Worker. `.zst` assets and `Content-Encoding: zstd` responses the browser did not decode
+ * itself are streamed through the decoder and answered with their original content type, so a
+ * PWA can serve zstd to browsers without native support.
+ *
+ * ```js
+ * // sw.js, registered with navigator.serviceWorker.register('/sw.js', { type: 'module' })
+ * import { registerZstdServiceWorker } from 'zstd-wasm-decoder/service-worker';
+ * registerZstdServiceWorker({ dictionaries: ['/dict/app.dict'] });
+ * ```
+ */
+
+// Web entrypoint: registers the wasm loader (zstd-decoder.wasm next to this module)
+import { setupZstdDecoder } from './index.web.js';
+import { _decodeResponse, type ZstdServiceWorkerOptions } from './response.js';
+
+// biome-ignore lint/performance/noBarrelFile: entrypoint module
+export { decodeZstdResponse, setupZstdDecoder, ZstdDecompressionStream } from './index.web.js';
+export type { ZstdServiceWorkerOptions } from './response.js';
+
+/**
+ * Installs the fetch handler. Call it once, at the top level of the worker script (fetch
+ * listeners have to be added during its first evaluation).
+ */
+export const registerZstdServiceWorker = (options: ZstdServiceWorkerOptions = {}): void => {
+  const scope = globalThis as any;
+  const { match, dictionaries, ...decodeOptions } = options;
+  // Loaded once, waited for by the first zstd responses only. A dictionary failing to load only
+  // fails the frames referencing it
+  const ready = setupZstdDecoder({ dictionaries }).catch(() => {});
+
+  scope.addEventListener('fetch', (event: any) => {
+    const request: Request = event.request;
+    if (
+      match
+        ? !match(request)
+        : request.method != 'GET' || new URL(request.url).origin != scope.location.origin
+    ) {
+      return;
+    }
+    event.respondWith(
+      fetch(request).then((response) => _decodeResponse(response, decodeOptions, ready)),
+    );
+  });
+};
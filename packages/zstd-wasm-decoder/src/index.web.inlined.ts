@@ -6,19 +6,42 @@
  */
 
 import { _internal } from './shared.js';
+import { _setupWebStreamWorker } from './stream-worker.js';
 
 // biome-ignore lint/performance/noBarrelFile: entrypoint module
 export {
+  calibrateMemory,
   createDecoder,
+  decodeRecords,
   decompress,
   decompressStream,
   decompressSync,
+  decompressToString,
+  getResultCacheStats,
+  setupResultCache,
   setupZstdDecoder,
   ZstdDecoder,
   ZstdDecompressionStream,
 } from './shared.js';
 
-export type { DecoderOptions, StreamResult } from './types.js';
+export { decodeZstdResponse } from './response.js';
+export { TarZstReader } from './tar.js';
+export type { TarEntry, TarEntryType, TarHeader, TarZstOptions } from './tar.js';
+
+export type {
+  DecoderMemory,
+  DecoderOptions,
+  MemoryCalibration,
+  ResultCacheOptions,
+  ResultCacheStats,
+  StreamResult,
+  TableCacheStats,
+  ZstdRecordOptions,
+  ZstdStreamOptions,
+} from './types.js';
+
+// ZstdDecompressionStream({ worker: true }): this module again, in a module Worker
+_setupWebStreamWorker(import.meta.url);
 
 _internal._loader = async () => {
   return await WebAssembly.compile(
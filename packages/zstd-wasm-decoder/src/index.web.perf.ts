@@ -0,0 +1,17 @@
+import { _internal } from './shared.js';
+import { _setupWebStreamWorker } from './stream-worker.js';
+
+// Web entry of the perf build (`zstd-wasm-decoder/perf/external`): references the perf wasm only,
+// the exports come from web.js rather than from the size build's entry and its wasm URL
+// biome-ignore lint/performance/noBarrelFile: entrypoint module
+export * from './web.js';
+
+// ZstdDecompressionStream({ worker: true }): this module again, in a module Worker
+_setupWebStreamWorker(import.meta.url);
+
+_internal._loader = async (wasmPath?: string) => {
+  const response = await fetch(
+    wasmPath || new URL('./zstd-decoder-perf.wasm', import.meta.url).href,
+  );
+  return await WebAssembly.compileStreaming(response);
+};
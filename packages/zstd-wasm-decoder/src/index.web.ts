@@ -1,18 +1,13 @@
 import { _internal } from './shared.js';
+import { _setupWebStreamWorker } from './stream-worker.js';
 
 // biome-ignore lint/performance/noBarrelFile: entrypoint module
-export {
-  createDecoder,
-  decompress,
-  decompressStream,
-  decompressSync,
-  setupZstdDecoder,
-  ZstdDecoder,
-  ZstdDecompressionStream,
-} from './shared.js';
+export * from './web.js';
+
+// ZstdDecompressionStream({ worker: true }): this module again, in a module Worker
+_setupWebStreamWorker(import.meta.url);
 
 _internal._loader = async (wasmPath?: string) => {
-  const wasmUrl = wasmPath || new URL('./zstd-decoder.wasm', import.meta.url).href;
-  const response = await fetch(wasmUrl);
+  const response = await fetch(wasmPath || new URL('./zstd-decoder.wasm', import.meta.url).href);
   return await WebAssembly.compileStreaming(response);
 };
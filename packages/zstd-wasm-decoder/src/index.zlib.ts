@@ -0,0 +1,296 @@
+import { Buffer, kMaxLength } from 'node:buffer';
+import { availableParallelism } from 'node:os';
+import { isMainThread, parentPort, Worker, workerData } from 'node:worker_threads';
+// Registers the wasm loader (and the native addon when built)
+import './index.node.js';
+import { _acquireDecoderSync, _getDictId, _releaseDecoder } from './shared.js';
+import { _concatUint8Arrays, _fcs, _fss } from './utils.js';
+
+// biome-ignore lint/performance/noBarrelFile: entrypoint module
+export { createZstdDecompress, ZstdDecompress } from './node-stream.js';
+export type { ZstdDecompressOptions } from './node-stream.js';
+
+/**
+ * `zstd-wasm-decoder/zlib`: drop-in for the zstd convenience methods of node:zlib
+ * (Node >= 22.15), for older Node versions and runtimes without them.
+ *
+ * ```js
+ * import { zstdDecompress, zstdDecompressSync } from 'zstd-wasm-decoder/zlib';
+ * ```
+ *
+ * Errors carry zlib's `code` / `errno` (`ZSTD_error_*`, `ERR_BUFFER_TOO_LARGE`).
+ * The async variant runs on a small worker_threads pool, each worker holding its own decoders.
+ */
+
+/**
+ * Options of {@link zstdDecompressSync} / {@link zstdDecompress}, as in node:zlib
+ */
+export interface ZstdDecompressSyncOptions {
+  /** Dictionary for frames that reference one (otherwise taken from setupZstdDecoder) */
+  dictionary?: Uint8Array | ArrayBuffer;
+  /** Limits the output size, throws a RangeError (ERR_BUFFER_TOO_LARGE) above. Default: buffer.kMaxLength */
+  maxOutputLength?: number;
+  /** Decompression parameters, only ZSTD_d_windowLogMax is applied (the window is capped at 8 MB by the build) */
+  params?: Record<number, number>;
+  /** Accepted for zlib compatibility, output is sized by the decoder */
+  chunkSize?: number;
+  /** Accepted for zlib compatibility */
+  info?: boolean;
+}
+
+export type ZstdInput = string | ArrayBuffer | NodeJS.ArrayBufferView;
+export type ZstdCallback = (error: Error | null, result: Buffer) => void;
+
+/**
+ * The subset of zlib.constants relevant to zstd decompression
+ */
+export const constants = {
+  ZSTD_d_windowLogMax: 100,
+  ZSTD_WINDOWLOG_LIMIT_DEFAULT: 27,
+} as const;
+
+// ZSTD_ErrorCode => [name, ZSTD_getErrorString()], decoding errors only
+const _ZSTD_ERRORS: Record<number, [string, string]> = {
+  1: ['GENERIC', 'Error (generic)'],
+  10: ['prefix_unknown', 'Unknown frame descriptor'],
+  12: ['version_unsupported', 'Version not supported'],
+  14: ['frameParameter_unsupported', 'Unsupported frame parameter'],
+  16: ['frameParameter_windowTooLarge', 'Frame requires too much memory for decoding'],
+  20: ['corruption_detected', 'Data corruption detected'],
+  22: ['checksum_wrong', 'Restored data doesn\'t match checksum'],
+  24: ['literals_headerWrong', 'Header of Literals\' block doesn\'t respect format specification'],
+  30: ['dictionary_corrupted', 'Dictionary is corrupted'],
+  32: ['dictionary_wrong', 'Dictionary mismatch'],
+  64: ['memory_allocation', 'Allocation error : not enough memory'],
+  66: ['workSpace_tooSmall', 'workSpace buffer is not large enough'],
+  70: ['dstSize_tooSmall', 'Destination buffer is too small'],
+  72: ['srcSize_wrong', 'Src size is incorrect'],
+};
+
+const _zstdError = (errno: number): Error => {
+  const [name, message] = _ZSTD_ERRORS[errno] || _ZSTD_ERRORS[1];
+  return Object.assign(new Error(message), { errno, code: `ZSTD_error_${name}` });
+};
+
+const _tooLarge = (max: number): RangeError =>
+  Object.assign(new RangeError(`Cannot create a Buffer larger than ${max} bytes`), {
+    code: 'ERR_BUFFER_TOO_LARGE',
+  });
+
+// `dec err -N` from the decoder => zlib shaped error
+const _toZlibError = (error: unknown): unknown => {
+  const match = error instanceof Error && /^dec err -(\d+)$/.exec(error.message);
+  return match ? _zstdError(+match[1]) : error;
+};
+
+const _toUint8Array = (input: ZstdInput): Uint8Array => {
+  if (typeof input == 'string') return Buffer.from(input);
+  if (input instanceof Uint8Array) return input;
+  if (ArrayBuffer.isView(input)) return new Uint8Array(input.buffer, input.byteOffset, input.byteLength);
+  if (input instanceof ArrayBuffer) return new Uint8Array(input);
+  throw Object.assign(
+    new TypeError(
+      'The "buffer" argument must be of type string or an instance of Buffer, TypedArray, DataView, or ArrayBuffer.',
+    ),
+    { code: 'ERR_INVALID_ARG_TYPE' },
+  );
+};
+
+const _toBuffer = (output: Uint8Array): Buffer =>
+  Buffer.from(output.buffer, output.byteOffset, output.byteLength);
+
+const _maxOutputLength = (options?: ZstdDecompressSyncOptions): number => {
+  const max = options?.maxOutputLength ?? kMaxLength;
+  if (!Number.isInteger(max) || max < 1 || max > kMaxLength) {
+    throw Object.assign(
+      new RangeError(
+        `The value of "options.maxOutputLength" is out of range. It must be >= 1 and <= ${kMaxLength}. Received ${max}`,
+      ),
+      { code: 'ERR_OUT_OF_RANGE' },
+    );
+  }
+  return max;
+};
+
+// Window size of the first frame (as rzfh, without its 10 MB content size cap), 0 if not a zstd frame
+const _windowSize = (dat: Uint8Array): number => {
+  if (dat.length < 6 || (dat[0] | (dat[1] << 8) | (dat[2] << 16)) != 0x2fb528 || dat[3] != 253) return 0;
+  if ((dat[4] >> 5) & 1) return _fss(dat);
+  const wb = 2 ** (10 + (dat[5] >> 3));
+  return wb + (wb / 8) * (dat[5] & 7);
+};
+
+/**
+ * Decode all frames of `input`, within maxOutputLength & ZSTD_d_windowLogMax
+ */
+const _decompress = (input: Uint8Array, options?: ZstdDecompressSyncOptions): Uint8Array => {
+  const max = _maxOutputLength(options);
+  const windowLogMax = options?.params?.[constants.ZSTD_d_windowLogMax];
+  const windowSize = _windowSize(input);
+  if (windowLogMax && windowSize > 2 ** windowLogMax) throw _zstdError(16);
+
+  // Declared content size (single segment, or frame content size field)
+  const contentSize = windowSize && input[4] >> 5 ? _fss(input) : 0;
+  if (contentSize > max) throw _tooLarge(max);
+
+  const dictId = _getDictId(input);
+  const [decoder, idx] = _acquireDecoderSync(dictId, options);
+  try {
+    // A single frame of known size: single pass (streamed internally above the wasm buffers)
+    if (contentSize && _fcs(input) == input.length) return decoder.decompressSync(input, contentSize);
+
+    // Unknown size or concatenated frames: stop as soon as the limit is crossed
+    const chunks: Uint8Array[] = [];
+    let total = 0;
+    decoder.decompressStream(input, true, (chunk) => {
+      total += chunk.length;
+      if (total > max) throw _tooLarge(max);
+      chunks.push(chunk);
+    });
+    return _concatUint8Arrays(chunks, total);
+  } catch (error) {
+    throw _toZlibError(error);
+  } finally {
+    idx == -1 ? decoder._destroy() : _releaseDecoder(idx, dictId);
+  }
+};
+
+/**
+ * Drop-in for zlib.zstdDecompressSync
+ *
+ * @param buffer - Compressed data, one or more (concatenated) frames
+ * @param options - zlib options (maxOutputLength, params[ZSTD_d_windowLogMax], dictionary)
+ * @returns Decompressed data
+ */
+export const zstdDecompressSync = /*! @__PURE__ */ (
+  buffer: ZstdInput,
+  options?: ZstdDecompressSyncOptions,
+): Buffer => _toBuffer(_decompress(_toUint8Array(buffer), options));
+
+/**
+ * Worker pool for zstdDecompress. Workers are spawned on demand (up to _POOL_MAX),
+ * and only keep the process alive while they have jobs in flight.
+ */
+const _WORKER_TAG = 'zstd-wasm-decoder/zlib';
+const _POOL_MAX = Math.max(1, Math.min(availableParallelism() - 1, 4));
+
+interface _Job {
+  id: number;
+  input: Uint8Array;
+  options?: ZstdDecompressSyncOptions;
+}
+
+interface _Result {
+  id: number;
+  output?: Uint8Array;
+  error?: { name: string; message: string; code?: string; errno?: number };
+}
+
+interface _PoolWorker {
+  worker: Worker;
+  pending: Map<number, ZstdCallback>;
+}
+
+const workers: _PoolWorker[] = [];
+let nextJobId = 0;
+
+const _fromWorkerError = ({ name, message, code, errno }: NonNullable<_Result['error']>): Error => {
+  const error = name == 'RangeError' ? new RangeError(message) : new Error(message);
+  return Object.assign(error, code === undefined ? {} : { code }, errno === undefined ? {} : { errno });
+};
+
+const _spawn = (): _PoolWorker => {
+  const entry: _PoolWorker = {
+    worker: new Worker(new URL(import.meta.url), { workerData: _WORKER_TAG }),
+    pending: new Map(),
+  };
+  const { worker, pending } = entry;
+
+  worker.on('message', ({ id, output, error }: _Result) => {
+    const callback = pending.get(id)!;
+    pending.delete(id);
+    if (!pending.size) worker.unref();
+    error ? callback(_fromWorkerError(error), undefined as never) : callback(null, _toBuffer(output!));
+  });
+  // A dead worker fails its jobs, the next call spawns a replacement
+  const fail = (error: Error) => {
+    if (workers.includes(entry)) workers.splice(workers.indexOf(entry), 1);
+    for (const callback of pending.values()) callback(error, undefined as never);
+    pending.clear();
+  };
+  worker.on('error', fail);
+  worker.on('exit', (code) => {
+    if (workers.includes(entry)) fail(new Error(`zstd worker exited with code ${code}`));
+  });
+
+  workers.push(entry);
+  return entry;
+};
+
+// Least loaded worker, a new one while the pool isn't full and all are busy
+const _pick = (): _PoolWorker => {
+  let best: _PoolWorker | undefined;
+  for (const entry of workers) {
+    if (!best || entry.pending.size < best.pending.size) best = entry;
+  }
+  return best && (!best.pending.size || workers.length >= _POOL_MAX) ? best : _spawn();
+};
+
+/**
+ * Drop-in for zlib.zstdDecompress, decoded off the main thread.
+ * Works with util.promisify.
+ *
+ * @param buffer - Compressed data, one or more (concatenated) frames
+ * @param options - zlib options (maxOutputLength, params[ZSTD_d_windowLogMax], dictionary)
+ * @param callback - Receives the decompressed Buffer, or a zlib shaped error
+ */
+export function zstdDecompress(buffer: ZstdInput, callback: ZstdCallback): void;
+export function zstdDecompress(
+  buffer: ZstdInput,
+  options: ZstdDecompressSyncOptions | undefined,
+  callback: ZstdCallback,
+): void;
+export function zstdDecompress(
+  buffer: ZstdInput,
+  options: ZstdDecompressSyncOptions | ZstdCallback | undefined,
+  callback?: ZstdCallback,
+): void {
+  if (typeof options == 'function') {
+    callback = options;
+    options = undefined;
+  }
+  if (typeof callback != 'function') {
+    throw Object.assign(new TypeError('The "callback" argument must be of type function.'), {
+      code: 'ERR_INVALID_ARG_TYPE',
+    });
+  }
+  _maxOutputLength(options);
+
+  // Copied (as zlib does) into its own ArrayBuffer, which is transferred to the worker
+  const input = new Uint8Array(_toUint8Array(buffer));
+  const { dictionary, maxOutputLength, params } = options || {};
+  const { worker, pending } = _pick();
+  const id = nextJobId++;
+
+  pending.set(id, callback);
+  worker.ref();
+  worker.postMessage(
+    { id, input, options: { dictionary, maxOutputLength, params } } satisfies _Job,
+    [input.buffer as ArrayBuffer],
+  );
+}
+
+// Worker side: the same module, loaded by _spawn
+if (!isMainThread && workerData === _WORKER_TAG) {
+  parentPort!.on('message', ({ id, input, options }: _Job) => {
+    try {
+      const output = _decompress(input, options);
+      // Decoder outputs usually own their buffer (slice / concat): moved back without a copy
+      const owned = output.byteLength && output.byteLength == output.buffer.byteLength;
+      parentPort!.postMessage({ id, output } satisfies _Result, owned ? [output.buffer as ArrayBuffer] : []);
+    } catch (error) {
+      const { name, message, code, errno } = error as Error & { code?: string; errno?: number };
+      parentPort!.postMessage({ id, error: { name, message, code, errno } } satisfies _Result);
+    }
+  });
+}
@@ -0,0 +1,165 @@
+import { Transform, type TransformCallback, type TransformOptions } from 'node:stream';
+import { _acquireDecoder, _getDictId, _releaseDecoder, type ZstdDecoder } from './shared.js';
+import type { ZstdOptions } from './types.js';
+
+/**
+ * Options of {@link createZstdDecompress}, a superset of zlib's zstd stream options.
+ */
+export interface ZstdDecompressOptions extends TransformOptions {
+  /** Dictionary for frames that reference one (otherwise taken from setupZstdDecoder) */
+  dictionary?: Uint8Array | ArrayBuffer;
+  /** Accepted for zlib compatibility, output slices are sized by the decoder */
+  chunkSize?: number;
+  /** Accepted for zlib compatibility, decompression parameters are fixed by the build */
+  params?: Record<number, number>;
+  /** Accepted for zlib compatibility, which applies it to the convenience methods only */
+  maxOutputLength?: number;
+}
+
+// Largest possible frame header, enough for _getDictId
+const _HEADER_MAX = 18;
+// Input decoded between two backpressure checks: sized from the observed ratio for about 1 MB
+// of output, so that highly compressed frames can't flood the readable side either
+const _STEP_MIN = 32;
+const _STEP_MAX = 1 << 16;
+const _STEP_OUT = 1 << 20;
+
+// Input ending inside a frame, as zlib reports it
+const _truncated = (): Error =>
+  Object.assign(new Error('unexpected end of file'), { errno: -5, code: 'Z_BUF_ERROR' });
+
+/**
+ * Node stream.Transform over a pooled decoder. Written chunks are decoded synchronously, about
+ * 1 MB of output at a time, and each flushed output slice is pushed as is. When the readable
+ * side is full, decoding resumes on the next read.
+ */
+export class ZstdDecompress extends Transform {
+  /** Compressed bytes consumed so far (zlib compatible) */
+  bytesWritten = 0;
+
+  private readonly _options: ZstdOptions;
+  private _decoder: ZstdDecoder | null = null;
+  private _idx = -1;
+  private _dictId = 0;
+  private _reset = true;
+  private _pending: Uint8Array[] = [];
+  private _pendingLen = 0;
+  private _step = 256;
+  private _out = 0;
+  private _full = false;
+  private _resume: (() => void) | null = null;
+  private readonly _emit = (chunk: Uint8Array) => {
+    this._out += chunk.length;
+    if (!this.push(chunk)) this._full = true;
+  };
+
+  constructor(options: ZstdDecompressOptions = {}) {
+    const { dictionary, chunkSize, params, maxOutputLength, ...streamOptions } = options;
+    super(streamOptions);
+    this._options = { dictionary };
+  }
+
+  _transform(chunk: Buffer, _encoding: BufferEncoding, callback: TransformCallback) {
+    this.bytesWritten += chunk.length;
+    if (this._decoder) return this._decode(chunk, callback);
+
+    // Hold back until the frame header (dictionary ID) is complete
+    this._pending.push(chunk);
+    this._pendingLen += chunk.length;
+    if (this._pendingLen < _HEADER_MAX) return callback();
+    this._start(callback);
+  }
+
+  _flush(callback: TransformCallback) {
+    const done = (error?: Error | null) => {
+      this._release();
+      callback(error);
+    };
+    const end = (error?: Error | null) => {
+      if (!error && this._decoder?._midFrame()) error = _truncated();
+      done(error);
+    };
+    if (this._decoder || !this._pendingLen) return end();
+    this._start(end);
+  }
+
+  _read(size: number) {
+    const resume = this._resume;
+    this._resume = null;
+    resume?.();
+    super._read(size);
+  }
+
+  _destroy(error: Error | null, callback: (error?: Error | null) => void) {
+    this._resume = null;
+    this._release();
+    callback(error);
+  }
+
+  /**
+   * Start over with a new frame (zlib compatible)
+   */
+  reset() {
+    this._reset = true;
+  }
+
+  /**
+   * Destroy the stream (zlib compatible)
+   */
+  close(callback?: () => void) {
+    if (callback) this.once('close', callback);
+    this.destroy();
+  }
+
+  private _start(callback: TransformCallback) {
+    const input = Buffer.concat(this._pending, this._pendingLen);
+    this._pending = [];
+    this._pendingLen = 0;
+    this._dictId = _getDictId(input);
+    _acquireDecoder(this._dictId, this._options).then(([decoder, idx]) => {
+      this._decoder = decoder;
+      this._idx = idx;
+      if (this.destroyed) return this._release();
+      this._decode(input, callback);
+    }, callback);
+  }
+
+  private _decode(input: Uint8Array, callback: TransformCallback, offset = 0) {
+    try {
+      while (offset < input.length) {
+        const end = Math.min(offset + this._step, input.length);
+        this._full = false;
+        this._out = 0;
+        this._decoder!.decompressStream(input.subarray(offset, end), this._reset, this._emit);
+        this._reset = false;
+        const next = this._out ? ((end - offset) * _STEP_OUT) / this._out : this._step * 2;
+        this._step = Math.max(_STEP_MIN, Math.min(_STEP_MAX, next | 0));
+        offset = end;
+        if (this._full && offset < input.length) {
+          this._resume = () => this._decode(input, callback, offset);
+          return;
+        }
+      }
+    } catch (error) {
+      return callback(error as Error);
+    }
+    callback();
+  }
+
+  private _release() {
+    if (!this._decoder) return;
+    this._idx == -1 ? this._decoder._destroy() : _releaseDecoder(this._idx, this._dictId);
+    this._decoder = null;
+  }
+}
+
+/**
+ * Drop-in for zlib.createZstdDecompress, for use with stream.pipeline()
+ *
+ * ```js
+ * await pipeline(createReadStream('file.zst'), createZstdDecompress(), createWriteStream('file'));
+ * ```
+ */
+export const createZstdDecompress = /*! @__PURE__ */ (
+  options?: ZstdDecompressOptions,
+): ZstdDecompress => new ZstdDecompress(options);
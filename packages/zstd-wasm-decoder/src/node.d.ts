@@ -0,0 +1,36 @@
+import type { Transform } from 'node:stream';
+import type { ZstdDecompressOptions } from './node-stream.js';
+
+// Node only declarations, on top of the runtime independent ones of index.d.ts
+export * from './index.js';
+export type { ZstdDecompressOptions };
+
+/**
+ * Node `stream.Transform` for Zstandard decompression, API compatible with zlib's `ZstdDecompress`.
+ *
+ * Chunks are decoded synchronously on a pooled decoder as they are written, every output
+ * slice is pushed as is, pausing while the readable side is full. Concatenated frames are
+ * decoded back to back, input ending inside a frame errors with `unexpected end of file`.
+ *
+ * @example
+ * ```ts
+ * await pipeline(createReadStream('file.zst'), createZstdDecompress(), createWriteStream('file'));
+ * ```
+ */
+export declare class ZstdDecompress extends Transform {
+  constructor(options?: ZstdDecompressOptions);
+  /** Compressed bytes consumed so far */
+  bytesWritten: number;
+  /** Start over with a new frame */
+  reset(): void;
+  /** Destroy the stream */
+  close(callback?: () => void): void;
+}
+
+/**
+ * Drop-in for `zlib.createZstdDecompress`.
+ *
+ * @param options - `dictionary` plus the zlib / stream options (`chunkSize`, `params` and
+ *   `maxOutputLength` are accepted and ignored).
+ */
+export declare function createZstdDecompress(options?: ZstdDecompressOptions): ZstdDecompress;
@@ -0,0 +1,118 @@
+import { ZstdDecompressionStream } from './shared.js';
+import type { ZstdOptions } from './types.js';
+import { _concatUint8Arrays } from './utils.js';
+
+/**
+ * fetch() Responses holding zstd: `.zst` assets, or `Content-Encoding: zstd` bodies the runtime
+ * did not decode itself. The body is told apart by its first bytes (frame or skippable frame
+ * magic), so a runtime decoding zstd natively gets its response back untouched. Decoded bodies
+ * are streamed through a pooled ZstdDecompressionStream in lowLatency mode: each network chunk
+ * is decoded as it arrives. Dictionaries are resolved by ID (setupZstdDecoder).
+ */
+
+// Content types of .zst assets, by the extension under .zst
+const _TYPES: Record<string, string> = {
+  css: 'text/css',
+  csv: 'text/csv',
+  html: 'text/html',
+  js: 'text/javascript',
+  json: 'application/json',
+  map: 'application/json',
+  mjs: 'text/javascript',
+  svg: 'image/svg+xml',
+  txt: 'text/plain',
+  wasm: 'application/wasm',
+  xml: 'application/xml',
+};
+
+// Zstandard frame magic. A body opening with a skippable frame passes through: the stream decoder
+// reads its frame header from the first bytes
+const _zstd = (b: Uint8Array): boolean =>
+  b[0] == 0x28 && b[1] == 0xb5 && b[2] == 0x2f && b[3] == 0xfd;
+
+/**
+ * Decodes a fetch() Response holding zstd, streamed. Other responses (not zstd, bodiless, or
+ * already decoded by the runtime) are returned as is.
+ *
+ * ```js
+ * const response = await decodeZstdResponse(await fetch('/data/app.json.zst'));
+ * const data = await response.json();
+ * ```
+ */
+export const decodeZstdResponse = /*! @__PURE__ */ (
+  response: Response,
+  options: ZstdOptions = {},
+): Promise<Response> => _decodeResponse(response, options);
+
+/**
+ * decodeZstdResponse, waiting for ready (the Service Worker's dictionaries) only once the body
+ * turned out to be zstd
+ */
+export const _decodeResponse = /*! @__PURE__ */ async (
+  response: Response,
+  options: ZstdOptions,
+  ready?: Promise<unknown>,
+): Promise<Response> => {
+  const path = response.url.replace(/[?#].*$/, '');
+  const asset = path.endsWith('.zst');
+  const encoded = /^\s*zstd\s*$/i.test(response.headers.get('content-encoding') || '');
+  if (!response.body || (!asset && !encoded)) return response;
+
+  // Enough of the body to check its magic, then put back in front of the rest
+  const reader = response.body.getReader();
+  const head: Uint8Array[] = [];
+  let headLen = 0;
+  let done = false;
+  while (headLen < 4 && !done) {
+    const next = await reader.read();
+    done = next.done;
+    if (next.value?.length) {
+      head.push(next.value);
+      headLen += next.value.length;
+    }
+  }
+  const first = _concatUint8Arrays(head, headLen);
+  const body = new ReadableStream<Uint8Array>({
+    start(controller) {
+      if (headLen) controller.enqueue(first);
+      if (done) controller.close();
+    },
+    async pull(controller) {
+      const next = await reader.read();
+      next.done ? controller.close() : controller.enqueue(next.value);
+    },
+    cancel(reason) {
+      return reader.cancel(reason);
+    },
+  });
+
+  const headers = new Headers(response.headers);
+  const init = { status: response.status, statusText: response.statusText, headers };
+  if (headLen < 4 || !_zstd(first)) return new Response(body, init);
+
+  headers.delete('content-encoding');
+  headers.delete('content-length');
+  // .zst assets: the type of the name under .zst (app.js.zst => text/javascript), when known
+  if (!encoded) {
+    const name = path.slice(0, -4);
+    const type = _TYPES[name.slice(name.lastIndexOf('.') + 1).toLowerCase()];
+    if (type) headers.set('content-type', type);
+  }
+  await ready;
+  const decoded = body.pipeThrough(new ZstdDecompressionStream({ ...options, lowLatency: true }));
+  return new Response(decoded, init);
+};
+
+/**
+ * Options of the Service Worker (zstd-wasm-decoder/service-worker)
+ */
+export interface ZstdServiceWorkerOptions extends ZstdOptions {
+  /**
+   * Requests to pass through decodeZstdResponse (default: same origin GET requests, which covers
+   * both .zst assets and Content-Encoding: zstd responses)
+   */
+  match?: (request: Request) => boolean;
+
+  /** Dictionary URLs, loaded once and resolved by dictionary ID (see setupZstdDecoder) */
+  dictionaries?: string[];
+}
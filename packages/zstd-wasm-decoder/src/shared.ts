@@ -1,18 +1,50 @@
-import ZstdDecoder from './zstd-wasm.js';
+import ZstdDecoder, { _DDICT_SIZE, _MAX_DST_BUF, _SMALL_ARENA } from './zstd-wasm.js';
 export { default as ZstdDecoder, _MAX_SRC_BUF } from './zstd-wasm.js';
 
-import type { StreamResult, ZstdOptions } from './types.js';
-import { rzfh, type DZS, err, _concatUint8Arrays } from './utils.js';
+import type {
+  DecoderOptions,
+  HybridCalibration,
+  HybridMetrics,
+  MemoryCalibration,
+  NativeZstdProvider,
+  ResultCacheOptions,
+  ResultCacheStats,
+  StreamResult,
+  ZstdOptions,
+  ZstdRecordOptions,
+  ZstdStreamOptions,
+} from './types.js';
+import { rb, rzfh, type DZS, err, _concatUint8Arrays, _fcs, _fss, _h32 } from './utils.js';
 
 export const _internal = {
   _loader: null as ((wasmPath?: string) => WebAssembly.Module | Promise<WebAssembly.Module>) | null,
+  // Replaces the wasm instance per decoder when set (native addon, see index.node.ts)
+  _factory: null as ((options: DecoderOptions) => ZstdDecoder) | null,
+  // Runtime native zstd for the hybrid dispatcher (node:zlib / Bun, see index.node.ts)
+  _native: null as NativeZstdProvider | null,
+  // Replaces the per dictionary pools when set (budgeted Workers pool, see cloudflare-pool.ts)
+  _pool: null as _DecoderPool | null,
+  // Decode-ahead worker behind ZstdDecompressionStream({ worker: true }), see stream-worker.ts
+  _worker: null as
+    | ((options: ZstdStreamOptions) => TransformStream<BufferSource, Uint8Array | string>)
+    | null,
   buffer: {
     maxSrcSize: 0,
     maxDstSize: 0,
+    streamSizing: 'adaptive' as DecoderOptions['streamSizing'],
   },
   dictionaries: [] as string[],
 };
 
+/**
+ * External decoder pool. Index -1 is an ephemeral decoder, destroyed by the caller instead of released.
+ */
+export interface _DecoderPool {
+  acquire(dictId: number, create: () => ZstdDecoder): Promise<[ZstdDecoder, number]>;
+  acquireSync(dictId: number, create: () => ZstdDecoder): [ZstdDecoder, number];
+  release(idx: number): void;
+}
+
 // This is horrible tbh.
 const decoderPools = new Map<number, Map<number, ZstdDecoder>>();
 const poolLocks = new Map<number, boolean[]>();
@@ -22,9 +54,12 @@ let isInitialized = false;
 let cachedModule: WebAssembly.Module;
 
 const loadedDictionaries = new Map<number, Uint8Array>();
+// Forwarded to stream workers, which hold their own module state
+export { loadedDictionaries as _loadedDictionaries };
 
 function /*! @__PURE__ */ _createDecoderInstance(
   dictionary?: Uint8Array | ArrayBuffer,
+  fingerprint?: DecoderOptions['fingerprint'],
 ): ZstdDecoder {
   const dict =
     dictionary instanceof Uint8Array
@@ -33,7 +68,9 @@ function /*! @__PURE__ */ _createDecoderInstance(
         ? new Uint8Array(dictionary)
         : undefined;
 
-  const decoder = new ZstdDecoder({ ..._internal.buffer, dictionary: dict });
+  const options = { ..._internal.buffer, dictionary: dict, fingerprint };
+  if (_internal._factory) return _internal._factory(options);
+  const decoder = new ZstdDecoder(options);
   decoder.init(cachedModule);
   return decoder;
 }
@@ -41,28 +78,59 @@ function /*! @__PURE__ */ _createDecoderInstance(
 export const setupZstdDecoder = /*! @__PURE__ */ async (options: {
   maxSrcSize?: number;
   maxDstSize?: number;
-  dictionaries?: string[];
+  streamSizing?: DecoderOptions['streamSizing'];
+  /** URLs, or the dictionaries themselves */
+  dictionaries?: (string | Uint8Array)[];
 }) => {
   if (options.maxSrcSize) _internal.buffer.maxSrcSize = options.maxSrcSize;
   if (options.maxDstSize) _internal.buffer.maxDstSize = options.maxDstSize;
+  if (options.streamSizing) _internal.buffer.streamSizing = options.streamSizing;
 
   if (options.dictionaries) {
-    for (const url of options.dictionaries) {
-      const dict = await _loadResource(url);
-      const id = _getDictId(dict);
+    for (const resource of options.dictionaries) {
+      const dict = await _loadResource(resource);
+      const id = _dictHeaderId(dict);
       if (id > 0) loadedDictionaries.set(id, dict);
     }
   }
 };
 
-async function _acquireDecoder(
+export async function _acquireDecoder(
   dictId: number = 0,
   options?: ZstdOptions,
 ): Promise<[ZstdDecoder, number, number]> {
-  if (!cachedModule) {
+  if (!cachedModule && !_internal._factory) {
     const module = _internal._loader!();
     cachedModule = module instanceof Promise ? await module : module;
   }
+  if (_internal._pool) {
+    const [decoder, idx] = await _internal._pool.acquire(dictId, () => _createPooled(dictId, options));
+    return [decoder, idx, dictId];
+  }
+  return _acquireDecoderSync(dictId, options);
+}
+
+const _createPooled = (dictId: number, options?: ZstdOptions): ZstdDecoder =>
+  _createDecoderInstance(
+    dictId > 0 ? options?.dictionary || loadedDictionaries.get(dictId) : undefined,
+  );
+
+/**
+ * Synchronous acquire. Needs the module to be loaded already (or a sync loader, as in Node)
+ */
+export function _acquireDecoderSync(
+  dictId: number = 0,
+  options?: ZstdOptions,
+): [ZstdDecoder, number, number] {
+  if (!cachedModule && !_internal._factory) {
+    const module = _internal._loader!();
+    if (module instanceof Promise) throw new err('not init');
+    cachedModule = module;
+  }
+  if (_internal._pool) {
+    const [decoder, idx] = _internal._pool.acquireSync(dictId, () => _createPooled(dictId, options));
+    return [decoder, idx, dictId];
+  }
 
   if (!decoderPools.has(dictId)) {
     decoderPools.set(dictId, new Map());
@@ -79,9 +147,7 @@ async function _acquireDecoder(
     }
   }
 
-  const decoder = _createDecoderInstance(
-    dictId > 0 ? options?.dictionary || loadedDictionaries.get(dictId) : undefined,
-  );
+  const decoder = _createPooled(dictId, options);
 
   if (locks.length > 2) return [decoder, -1, dictId];
 
@@ -91,27 +157,12 @@ async function _acquireDecoder(
   return [decoder, newIdx, dictId];
 }
 
-function _releaseDecoder(idx: number, dictId: number): void {
+export function _releaseDecoder(idx: number, dictId: number): void {
+  if (_internal._pool) return _internal._pool.release(idx);
   const locks = poolLocks.get(dictId);
   if (locks) locks[idx] = false;
 }
 
-export function _pushToPool(
-  decoder: ZstdDecoder,
-  module: WebAssembly.Module,
-  dictId: number = 0,
-): void {
-  cachedModule = module;
-  if (!decoderPools.has(dictId)) {
-    decoderPools.set(dictId, new Map());
-    poolLocks.set(dictId, []);
-  }
-  const pool = decoderPools.get(dictId)!;
-  const locks = poolLocks.get(dictId)!;
-  pool.set(locks.length, decoder);
-  locks.push(false);
-}
-
 /**
  * Load resource as Uint8Array
  */
@@ -124,26 +175,325 @@ const _loadResource = /*! @__PURE__ */ async (
   return new Uint8Array(await response.arrayBuffer());
 };
 
-const _getDictId = /*! @__PURE__ */ (input: Uint8Array): number => {
+export const _getDictId = /*! @__PURE__ */ (input: Uint8Array): number => {
   if (input.length < 6) return 0;
   try {
     const header = rzfh(input);
-    const id = typeof header == 'object' ? header.d : 0;
-    if (id > 0) loadedDictionaries.set(id, input);
-    return id;
+    return typeof header == 'object' ? header.d : 0;
   } catch {
     return 0;
   }
 };
 
+// ID of a zstd dictionary (magic 0xEC30A437), 0 for raw content dictionaries
+const _dictHeaderId = (dict: Uint8Array): number =>
+  dict.length >= 8 && rb(dict, 0, 4) >>> 0 == 0xec30a437 ? rb(dict, 4, 4) >>> 0 : 0;
+
+/**
+ * Hybrid dispatch between wasm and the runtime's native zstd (opt-in, setupHybridDecoder).
+ * Routes per input size class & sync/async mode from a calibrated table.
+ */
+let hybridRoutes: HybridCalibration | null = null;
+const hybridMetrics: HybridMetrics = {
+  provider: '',
+  calibration: null,
+  sync: [],
+  async: [],
+  fallbacks: 0,
+};
+
+// <1k, <4k, <16k, <64k, <256k, <1m, <4m, >=4m
+const _sizeClass = (n: number): number => {
+  let c = 0;
+  for (let s = 1024; c < 7 && n >= s; s <<= 2) ++c;
+  return c;
+};
+
+// Like the wasm pools, a dictionary only applies to frames that reference one
+const _nativeDict = (dictId: number, options?: ZstdOptions): Uint8Array | undefined => {
+  if (!dictId) return;
+  const dict = options?.dictionary || loadedDictionaries.get(dictId);
+  return dict instanceof ArrayBuffer ? new Uint8Array(dict) : dict;
+};
+
+// Native only gets what it decodes exactly like wasm: one complete frame (native stops after
+// the first frame & accepts truncated input), window within the wasm limit, src within maxSrcSize.
+const _useNative = (
+  input: Uint8Array,
+  dictId: number,
+  mode: 'sync' | 'async',
+  options?: ZstdOptions,
+): boolean => {
+  const native = _internal._native!;
+  const cls = _sizeClass(input.length);
+  let route =
+    hybridRoutes![mode][cls] == 'n' &&
+    !(input.length > Math.max(_internal.buffer.maxSrcSize, _MAX_DST_BUF << 6)) &&
+    (dictId == 0 || (native.dict && !!_nativeDict(dictId, options)));
+  if (route) {
+    try {
+      route = (rzfh(input) as DZS).u <= 8388608 && _fcs(input) == input.length;
+    } catch {
+      route = false;
+    }
+  }
+  ++hybridMetrics[mode][cls][route ? 1 : 0];
+  return route;
+};
+
+const _maxDstLimit = (): number => Math.max(_internal.buffer.maxDstSize, _MAX_DST_BUF << 6);
+
+// Text-like filler for calibration samples
+const _calibrationSample = (size: number): Uint8Array => {
+  const words = 'the of zstd frame block window decoder stream offset literal sequence table'.split(' ');
+  let text = '';
+  for (let x = 0x9e3779b9; text.length < size; ) {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    text += (x & 15) < 12 ? `${words[(x >>> 4) % words.length]} ` : `${(x >>> 8) & 0xffff}, `;
+  }
+  return new TextEncoder().encode(text.slice(0, size));
+};
+
+const _calibrate = async (
+  native: NativeZstdProvider,
+  samples?: Uint8Array[],
+): Promise<HybridCalibration> => {
+  if (!samples?.length) {
+    samples = [];
+    if (native.compress) {
+      for (let size = 512; size <= 1 << 21; size <<= 2) {
+        samples.push(native.compress(_calibrationSample(size)));
+      }
+    }
+  }
+  const maxDstSize = _maxDstLimit();
+  // [class][wasm sync, native sync, wasm async, native async] in ms
+  const cost: number[][] = [];
+
+  for (const sample of samples) {
+    const reps = Math.max(2, Math.min(16, (1 << 18) / sample.length) | 0);
+    const dictId = _getDictId(sample);
+    const runs: Array<() => unknown> = [
+      () => _decompressSync(sample, dictId),
+      () => native.sync(sample, maxDstSize),
+      () => _decompress(sample, dictId),
+      () => native.async(sample, maxDstSize),
+    ];
+    const c = (cost[_sizeClass(sample.length)] ||= [0, 0, 0, 0]);
+    for (let r = 0; r < runs.length; ++r) {
+      try {
+        await runs[r]();
+        const start = performance.now();
+        for (let i = 0; i < reps; ++i) await runs[r]();
+        c[r] += (performance.now() - start) / reps;
+      } catch {
+        c[r] = Infinity;
+      }
+    }
+  }
+
+  // Classes without a sample take the route of the nearest measured one
+  const routes = (w: number, n: number) => {
+    let out = '';
+    for (let cls = 0; cls < 8; ++cls) {
+      let near = -1;
+      for (let i = 0; i < 8; ++i) {
+        if (cost[i] && (near == -1 || Math.abs(i - cls) < Math.abs(near - cls))) near = i;
+      }
+      out += near > -1 && cost[near][n] < cost[near][w] ? 'n' : 'w';
+    }
+    return out;
+  };
+  return { provider: native.name, sync: routes(0, 1), async: routes(2, 3) };
+};
+
+/**
+ * Opt into hybrid wasm / native dispatch. Calibrates against the runtime's native zstd, unless
+ * a calibration for the same provider is passed in. Without a native provider (browsers,
+ * Workers) everything stays on wasm.
+ */
+export const setupHybridDecoder = /*! @__PURE__ */ async (
+  options: { calibration?: HybridCalibration; samples?: Uint8Array[] } = {},
+): Promise<HybridCalibration | null> => {
+  const native = _internal._native;
+  hybridRoutes = null;
+  for (const mode of ['sync', 'async'] as const) {
+    hybridMetrics[mode] = Array.from({ length: 8 }, () => [0, 0]);
+  }
+  hybridMetrics.fallbacks = 0;
+  hybridMetrics.provider = native?.name || '';
+  hybridMetrics.calibration = null;
+  if (!native) return null;
+
+  const calibration =
+    options.calibration?.provider == native.name
+      ? options.calibration
+      : await _calibrate(native, options.samples);
+  hybridRoutes = hybridMetrics.calibration = calibration;
+  return calibration;
+};
+
+/**
+ * Memory calibration: decodes the samples (compressed frames representative of the workload) in
+ * a fresh wasm instance, one per dictionary, recording the memory high-water mark per window
+ * size. Frames without a content size are streamed, as decompressSync does.
+ */
+export const calibrateMemory = /*! @__PURE__ */ async (
+  samples: Uint8Array[],
+): Promise<MemoryCalibration> => {
+  if (!cachedModule) cachedModule = await _internal._loader!();
+  const decoders = new Map<number, ZstdDecoder>();
+  const windows = new Map<number, MemoryCalibration['windows'][number]>();
+  const pow2 = (n: number) => 2 ** Math.ceil(Math.log2(Math.max(n, 1) * 2));
+  let maxSrcSize = 0;
+  let maxDstSize = 0;
+  let small = true;
+
+  try {
+    for (const sample of samples) {
+      // Frame header: dictionary ID, window descriptor (or content size of single segment frames)
+      const single = (sample[4] >> 5) & 1;
+      const df = sample[4] & 3;
+      const dictId = rb(sample, 6 - single, df == 3 ? 4 : df) >>> 0;
+      const wb = 1 << (10 + (sample[5] >> 3));
+      const windowSize = single ? _fss(sample) : wb + (wb >> 3) * (sample[5] & 7);
+      let decoder = decoders.get(dictId);
+      if (!decoder) {
+        decoder = new ZstdDecoder({
+          ..._internal.buffer,
+          dictionary: dictId ? loadedDictionaries.get(dictId) : undefined,
+        }).init(cachedModule);
+        decoders.set(dictId, decoder);
+        decoder._highWater();
+      }
+      const size = decoder.decompressSync(sample).length;
+      const [memory, arena] = decoder._highWater();
+      const w = windows.get(windowSize) || { windowSize, frames: 0, memory: 0, arena: 0 };
+      windows.set(windowSize, w);
+      ++w.frames;
+      w.memory = Math.max(w.memory, memory);
+      w.arena = Math.max(w.arena, arena);
+      maxSrcSize = Math.max(maxSrcSize, sample.length);
+      maxDstSize = Math.max(maxDstSize, size);
+      // 1 MB + 1 window limit, stream arena past the small build's src area & the dictionary
+      const dictLen = loadedDictionaries.get(dictId)?.length;
+      small &&= windowSize <= 1048577 && arena <= _SMALL_ARENA - (dictLen ? dictLen + _DDICT_SIZE : 0);
+    }
+  } finally {
+    for (const decoder of decoders.values()) decoder._destroy();
+  }
+
+  const all = [...windows.values()].sort((a, b) => a.windowSize - b.windowSize);
+  return {
+    maxSrcSize: pow2(maxSrcSize),
+    maxDstSize: pow2(maxDstSize),
+    memorySize: Math.ceil(Math.max(0, ...all.map((w) => w.memory)) / 65536) * 65536,
+    small,
+    windows: all,
+  };
+};
+
+/**
+ * Routing decisions of the hybrid dispatcher (live object)
+ */
+export const getHybridMetrics = /*! @__PURE__ */ (): HybridMetrics => hybridMetrics;
+
+/**
+ * Decompressed result cache (opt-in, setupResultCache): outputs of decompress / decompressSync,
+ * keyed by a hash of the compressed input seeded with its dictionary ID, LRU (Map order) within
+ * a byte budget. Entries keep a copy of the input, so a hash collision is a miss.
+ */
+interface _CacheEntry {
+  dictId: number;
+  input: Uint8Array;
+  output: Uint8Array;
+}
+
+let resultCache: Map<number, _CacheEntry> | null = null;
+let resultCacheShared = false;
+const resultCacheStats = { hits: 0, misses: 0, bytes: 0, maxBytes: 0 };
+
+const _sameBytes = (a: Uint8Array, b: Uint8Array): boolean => {
+  if (a.length != b.length) return false;
+  for (let i = 0; i < a.length; ++i) if (a[i] != b[i]) return false;
+  return true;
+};
+
+const _cacheGet = (key: number, input: Uint8Array, dictId: number): Uint8Array | undefined => {
+  const entry = resultCache!.get(key);
+  if (!entry || entry.dictId != dictId || !_sameBytes(entry.input, input)) return;
+  // Most recently used last
+  resultCache!.delete(key);
+  resultCache!.set(key, entry);
+  ++resultCacheStats.hits;
+  return resultCacheShared ? entry.output : new Uint8Array(entry.output);
+};
+
+const _cachePut = (
+  key: number,
+  input: Uint8Array,
+  dictId: number,
+  output: Uint8Array,
+): Uint8Array => {
+  // Disabled meanwhile (setupResultCache during an async decode)
+  if (!resultCache) return output;
+  ++resultCacheStats.misses;
+  const size = input.length + output.length;
+  if (size > resultCacheStats.maxBytes) return output;
+  const previous = resultCache.get(key);
+  if (previous) {
+    resultCache.delete(key);
+    resultCacheStats.bytes -= previous.input.length + previous.output.length;
+  }
+  for (const [oldest, entry] of resultCache) {
+    if (resultCacheStats.bytes + size <= resultCacheStats.maxBytes) break;
+    resultCache.delete(oldest);
+    resultCacheStats.bytes -= entry.input.length + entry.output.length;
+  }
+  // Copies (Buffer#slice is a view). The caller owns the returned output unless shared
+  resultCache.set(key, {
+    dictId,
+    input: new Uint8Array(input),
+    output: resultCacheShared ? output : new Uint8Array(output),
+  });
+  resultCacheStats.bytes += size;
+  return output;
+};
+
+/**
+ * Opt into the decompressed result cache of decompress / decompressSync: byte-identical inputs
+ * (same dictionary ID) are answered from the cache without decoding. Resets the counters,
+ * maxBytes 0 disables & clears it.
+ */
+export const setupResultCache = /*! @__PURE__ */ (options: ResultCacheOptions): void => {
+  resultCache = options.maxBytes > 0 ? new Map() : null;
+  resultCacheShared = !!options.shared;
+  resultCacheStats.hits = resultCacheStats.misses = resultCacheStats.bytes = 0;
+  resultCacheStats.maxBytes = Math.max(0, options.maxBytes);
+};
+
+/**
+ * Result cache counters & occupancy snapshot
+ */
+export const getResultCacheStats = /*! @__PURE__ */ (): ResultCacheStats => {
+  const { hits, misses } = resultCacheStats;
+  return {
+    ...resultCacheStats,
+    hitRate: hits + misses ? hits / (hits + misses) : 0,
+    entries: resultCache?.size || 0,
+  };
+};
+
 export const createDecoder = /*! @__PURE__ */ async (
-  options: ZstdOptions = {},
+  options: ZstdOptions & Pick<DecoderOptions, 'fingerprint'> = {},
 ): Promise<ZstdDecoder> => {
-  if (!isInitialized) {
+  if (!isInitialized && !_internal._factory) {
     cachedModule = await _internal._loader!(options.wasmPath);
     isInitialized = true;
   }
-  return _createDecoderInstance(options.dictionary);
+  return _createDecoderInstance(options.dictionary, options.fingerprint);
 };
 
 const _toUint8Array = (chunk: BufferSource): Uint8Array => {
@@ -166,30 +516,50 @@ export class ZstdDecompressionStream {
   readonly writable: WritableStream;
 
   /**
-   * @param {ZstdOptions} [options] - Optional decoder configuration.
+   * @param {ZstdStreamOptions} [options] - Optional decoder configuration.
    */
-  constructor(options?: ZstdOptions) {
-    let decoder: ZstdDecoder;
+  constructor(options?: ZstdStreamOptions) {
+    if (options?.worker && _internal._worker) {
+      const { readable, writable } = _internal._worker(options);
+      this.readable = readable;
+      this.writable = writable;
+      return;
+    }
+    let decoder: ZstdDecoder | undefined;
     let idx: number = -1;
     let dictId: number = 0;
-    let isFirstChunk = true;
     // A temporary buffer to hold data until the header can be read.
     const initialBuffer: Uint8Array[] = [];
     let headerInfo: DZS = { d: 0, u: 0, e: -1 };
     let bytesRead: number = 0;
-    let bytesWritten: number = 0;
     let bufLen: number = 0;
-    let minRecvSize: number = 262144;
-
-    const { readable, writable } = new TransformStream<BufferSource, Uint8Array>({
+    // lowLatency: decoding starts with the chunk completing the frame header
+    const lowLatency = !!options?.lowLatency;
+    let minRecvSize: number = lowLatency ? _HEADER_MAX : 262144;
+
+    // output: 'text', UTF-8 decoded straight from wasm memory, sequences split across calls kept
+    const text = options?.output == 'text' ? new TextDecoder() : null;
+    const decode = (input: Uint8Array, reset: boolean): Uint8Array | string =>
+      text ? decoder!._text(input, reset, text) : decoder!.decompressStream(input, reset).buf;
+
+    const release = () => {
+      if (!decoder) return;
+      idx == -1 ? decoder._destroy() : _releaseDecoder(idx, dictId);
+      decoder = undefined;
+    };
+
+    const { readable, writable } = new TransformStream<BufferSource, Uint8Array | string>({
       async transform(
         chunk: BufferSource,
-        controller: TransformStreamDefaultController<Uint8Array>,
+        controller: TransformStreamDefaultController<Uint8Array | string>,
       ) {
         const data = _toUint8Array(chunk);
         bytesRead += data.length;
-        initialBuffer.push(data);
-        ++bufLen;
+        // Held until the decoder starts, then decoded chunk by chunk
+        if (!decoder) {
+          initialBuffer.push(data);
+          ++bufLen;
+        }
         // Wait until we have at least enough bytes for a full frame header.
         if (bytesRead < 12) {
           return;
@@ -203,67 +573,210 @@ export class ZstdDecompressionStream {
           }
           headerInfo = rzfh(headerBuffer) as DZS;
           // Adapt minimum receive size depending on header
-          minRecvSize = Math.max(minRecvSize, headerInfo.e, headerInfo.u >> 4, 1 << 17);
+          if (!lowLatency) minRecvSize = Math.max(minRecvSize, headerInfo.e, headerInfo.u >> 4, 1 << 17);
         }
         if (bytesRead < minRecvSize || headerInfo.e == -1) return;
 
         // After header probing, start streaming/decoding.
         if (decoder) {
-          const result = decoder.decompressStream(data, false).buf;
-          if (result.length > 0) {
-            controller.enqueue(result);
+          try {
+            const result = decode(data, false);
+            if (result.length > 0) {
+              controller.enqueue(result);
+            }
+          } catch (er) {
+            release();
+            throw er;
           }
           return;
         }
 
         try {
-          if (isFirstChunk) {
-            dictId = _getDictId(data);
-            [decoder, idx, dictId] = await _acquireDecoder(dictId, options);
-          }
-
-          const result = decoder!.decompressStream(data, isFirstChunk).buf;
-          bytesWritten += result.length;
-          controller.enqueue(result);
-          isFirstChunk = false;
+          // Everything buffered so far, frame header included
+          const input = _concatUint8Arrays(initialBuffer, bytesRead);
+          initialBuffer.length = bufLen = 0;
+          dictId = _getDictId(input);
+          [decoder, idx, dictId] = await _acquireDecoder(dictId, options);
+
+          const result = decode(input, true);
+          if (result.length > 0) controller.enqueue(result);
         } catch (er) {
+          release();
           controller.error(new err(`dec err ${er}`));
         }
       },
 
-      async flush(controller: TransformStreamDefaultController<Uint8Array>) {
-        if (bytesWritten == 0 && bytesRead > 6) {
-          try {
-            const res = await decompressStream(
-              _concatUint8Arrays(initialBuffer, bytesRead),
-              true,
-              options,
-            );
-            controller.enqueue(res.buf);
-          } catch (er) {
-            controller.error(new err(`dec err ${er}`));
-          }
-        } else {
-          if (idx == -1) {
-            decoder?._destroy();
-          } else {
-            _releaseDecoder(idx, dictId);
+      // Readable canceled / writable aborted, where TransformStream supports it
+      // (cloudflare-pool.ts wraps the readable side for a portable release)
+      cancel() {
+        release();
+      },
+
+      async flush(controller: TransformStreamDefaultController<Uint8Array | string>) {
+        try {
+          // Short input, still held back
+          if (!decoder && bytesRead) {
+            const input = _concatUint8Arrays(initialBuffer, bytesRead);
+            initialBuffer.length = bufLen = 0;
+            dictId = _getDictId(input);
+            [decoder, idx, dictId] = await _acquireDecoder(dictId, options);
+            const result = decode(input, true);
+            if (result.length > 0) controller.enqueue(result);
           }
+        } catch (er) {
+          release();
+          return controller.error(new err(`dec err ${er}`));
+        }
+        // Input cut inside a frame
+        if (decoder?._midFrame()) {
+          release();
+          return controller.error(new err('unexpected end of file'));
         }
+        // Incomplete trailing sequence, as U+FFFD
+        const tail = decoder && text ? text.decode() : '';
+        if (tail) controller.enqueue(tail);
+        release();
         controller.terminate();
       },
-    });
+    } as Transformer<BufferSource, Uint8Array | string>);
 
     this.readable = readable;
     this.writable = writable;
   }
 }
 
+// Largest possible frame header, enough for _getDictId
+export const _HEADER_MAX = 18;
+
+export const _chunks = async function* (
+  stream: ReadableStream<BufferSource> | AsyncIterable<BufferSource>,
+): AsyncGenerator<Uint8Array> {
+  if (!('getReader' in stream)) {
+    for await (const chunk of stream) yield _toUint8Array(chunk);
+    return;
+  }
+  const reader = stream.getReader();
+  try {
+    for (;;) {
+      const { done, value } = await reader.read();
+      if (done) return;
+      yield _toUint8Array(value);
+    }
+  } finally {
+    reader.releaseLock();
+  }
+};
+
+/**
+ * Decompresses a stream into records, split on a delimiter byte (newline by default) by the
+ * decoder: each flushed chunk is scanned in wasm, records are views into it, only the ones
+ * straddling two chunks are copied. Yields the records completed by each input chunk, the
+ * delimiter excluded. A last record without a trailing delimiter is yielded at the end.
+ */
+export const decodeRecords = /*! @__PURE__ */ async function* (
+  stream: ReadableStream<BufferSource> | AsyncIterable<BufferSource>,
+  options: ZstdRecordOptions = {},
+): AsyncGenerator<Uint8Array[]> {
+  let decoder: ZstdDecoder | undefined;
+  let idx = -1;
+  let dictId = 0;
+  let pending: Uint8Array[] = [];
+  let pendingLen = 0;
+  // Partial record at the end of the previous chunks
+  let carry: Uint8Array[] = [];
+  let carryLen = 0;
+  let batch: Uint8Array[] = [];
+
+  const emit = (chunk: Uint8Array, offsets?: Uint32Array) => {
+    let start = 0;
+    for (const end of offsets!) {
+      if (carryLen) {
+        carry.push(chunk.subarray(0, end));
+        batch.push(_concatUint8Arrays(carry, carryLen + end));
+        carry = [];
+        carryLen = 0;
+      } else {
+        batch.push(chunk.subarray(start, end));
+      }
+      start = end + 1;
+    }
+    if (start < chunk.length) {
+      carry.push(chunk.subarray(start));
+      carryLen += chunk.length - start;
+    }
+  };
+
+  // Everything buffered so far, frame header included
+  const start = async () => {
+    const input = _concatUint8Arrays(pending, pendingLen);
+    pending = [];
+    [decoder, idx, dictId] = await _acquireDecoder(_getDictId(input), options);
+    decoder.recordDelimiter(options.delimiter ?? 0x0a);
+    decoder.decompressStream(input, true, emit);
+  };
+
+  try {
+    for await (const input of _chunks(stream)) {
+      if (decoder) {
+        decoder.decompressStream(input, false, emit);
+      } else {
+        pending.push(input);
+        pendingLen += input.length;
+        if (pendingLen < _HEADER_MAX) continue;
+        await start();
+      }
+      if (batch.length) {
+        yield batch;
+        batch = [];
+      }
+    }
+    if (!decoder && pendingLen) await start();
+    if (carryLen) batch.push(_concatUint8Arrays(carry, carryLen));
+    if (batch.length) yield batch;
+  } finally {
+    if (decoder) {
+      decoder.recordDelimiter();
+      idx == -1 ? decoder._destroy() : _releaseDecoder(idx, dictId);
+    }
+  }
+};
+
 export const decompress = /*! @__PURE__ */ async (
   input: Uint8Array,
   options?: ZstdOptions,
 ): Promise<Uint8Array> => {
-  return (await decompressStream(input, true, options)).buf;
+  const dictId = _getDictId(input);
+  if (!resultCache) return _decompress(input, dictId, options);
+  const key = _h32(input, dictId);
+  return (
+    _cacheGet(key, input, dictId) ||
+    _cachePut(key, input, dictId, await _decompress(input, dictId, options))
+  );
+};
+
+const _decompress = async (
+  input: Uint8Array,
+  dictId: number,
+  options?: ZstdOptions,
+): Promise<Uint8Array> => {
+  if (hybridRoutes) {
+    // Native failures (and outputs above maxDstSize) are replayed on wasm,
+    // so errors keep their wasm codes & messages
+    if (_useNative(input, dictId, 'async', options)) {
+      try {
+        const result = await _internal._native!.async(input, _maxDstLimit(), _nativeDict(dictId, options));
+        if (result.length <= _maxDstLimit()) return result;
+      } catch {}
+      ++hybridMetrics.fallbacks;
+    }
+  }
+  // Header already parsed for its dictionary ID: decoded here rather than by decompressStream
+  const [decoder, idx, id] = await _acquireDecoder(dictId, options);
+  try {
+    return decoder.decompressStream(input, true).buf;
+  } finally {
+    idx == -1 ? decoder._destroy() : _releaseDecoder(idx, id);
+  }
 };
 
 export const decompressStream = /*! @__PURE__ */ async (
@@ -284,7 +797,51 @@ export const decompressSync = /*! @__PURE__ */ (
   options?: ZstdOptions,
 ): Uint8Array => {
   const dictId = _getDictId(input);
-  const decoder = decoderPools.get(dictId)?.get(0) || _createDecoderInstance(dictId > 0 ? options?.dictionary || loadedDictionaries.get(dictId) : undefined);
-  const result = decoder.decompressSync(input, expectedSize);
-  return result;
+  if (!resultCache) return _decompressSync(input, dictId, expectedSize, options);
+  const key = _h32(input, dictId);
+  return (
+    _cacheGet(key, input, dictId) ||
+    _cachePut(key, input, dictId, _decompressSync(input, dictId, expectedSize, options))
+  );
+};
+
+const _utf8 = /*! @__PURE__ */ new TextDecoder();
+
+/**
+ * decompressSync to a string: UTF-8 decoded from views of wasm memory, without the output copy.
+ * Hybrid (native) routes and result cache hits decode their output buffer instead.
+ */
+export const decompressToString = /*! @__PURE__ */ (
+  input: Uint8Array,
+  options?: ZstdOptions,
+): string => {
+  if (hybridRoutes || resultCache) return _utf8.decode(decompressSync(input, undefined, options));
+  const [decoder, idx, dictId] = _acquireDecoderSync(_getDictId(input), options);
+  try {
+    return decoder.decompressToString(input);
+  } finally {
+    idx == -1 ? decoder._destroy() : _releaseDecoder(idx, dictId);
+  }
+};
+
+const _decompressSync = (
+  input: Uint8Array,
+  dictId: number,
+  expectedSize?: number,
+  options?: ZstdOptions,
+): Uint8Array => {
+  if (hybridRoutes && _useNative(input, dictId, 'sync', options)) {
+    try {
+      const result = _internal._native!.sync(input, _maxDstLimit(), _nativeDict(dictId, options));
+      if (result.length <= _maxDstLimit()) return result;
+    } catch {}
+    ++hybridMetrics.fallbacks;
+  }
+  // Leased like any other use: slot 0 may be mid-way through a stream
+  const [decoder, idx] = _acquireDecoderSync(dictId, options);
+  try {
+    return decoder.decompressSync(input, expectedSize);
+  } finally {
+    idx == -1 ? decoder._destroy() : _releaseDecoder(idx, dictId);
+  }
 };
@@ -0,0 +1,223 @@
+import { _internal, _loadedDictionaries, setupZstdDecoder, ZstdDecompressionStream } from './shared.js';
+import type { ZstdStreamOptions } from './types.js';
+import { err } from './utils.js';
+
+/**
+ * Decode-ahead for ZstdDecompressionStream (`{ worker: true }`).
+ *
+ * A dedicated worker owns the decoder: compressed chunks are copied once and transferred to it,
+ * decoded chunks are transferred back. Up to `queueDepth` chunks are in flight, so the worker
+ * decodes ahead while the main thread consumes the previous output; writes wait beyond that.
+ * The entrypoint provides the spawn (worker_threads in Node, module Workers on the web), the
+ * worker side is the same module running {@link _serveStream}.
+ */
+
+/** main => worker: start a stream, compressed chunk, end of input */
+export type _ToWorker =
+  | { o: ZstdStreamOptions; s: typeof _internal.buffer & { dictionaries: [number, Uint8Array][] } }
+  | { c: Uint8Array }
+  | { e: 1 };
+
+/** worker => main: decoded chunk, compressed chunk consumed, stream done, failure */
+export type _FromWorker = { c: Uint8Array | string } | { a: 1 } | { d: 1 } | { x: string };
+
+export interface _WorkerHandle {
+  post(message: _ToWorker, transfer?: Transferable[]): void;
+  /** Node: only keep the process alive while streaming */
+  busy(on: boolean): void;
+  terminate(): void;
+  /** Set per stream. Receives the worker messages, or an Error when the worker died */
+  onmessage: (message: _FromWorker | Error) => void;
+}
+
+/** workerData (Node) / Worker name (web) of the stream workers */
+export const _STREAM_WORKER = 'zstd-wasm-decoder/stream';
+
+const _DEFAULT_DEPTH = 4;
+const _IDLE_MAX = 2;
+
+// Workers of finished streams, reused (the wasm module is already compiled there)
+const idle: _WorkerHandle[] = [];
+let spawn: (() => _WorkerHandle) | null = null;
+
+// Output chunks usually own their buffer (slice / concat): moved without a copy
+const _transfer = (chunk: Uint8Array | string): Transferable[] =>
+  typeof chunk != 'string' && chunk.byteLength && chunk.byteLength == chunk.buffer.byteLength
+    ? [chunk.buffer as ArrayBuffer]
+    : [];
+
+export const _installStreamWorker = (spawnWorker: () => _WorkerHandle): void => {
+  spawn = spawnWorker;
+  _internal._worker = _pipelined;
+};
+
+const _pipelined = (
+  options: ZstdStreamOptions,
+): TransformStream<BufferSource, Uint8Array | string> => {
+  const depth = Math.max(1, options.queueDepth || _DEFAULT_DEPTH);
+  let handle: _WorkerHandle | null = null;
+  let controller: TransformStreamDefaultController<Uint8Array | string>;
+  let inFlight = 0;
+  let done = false;
+  let failure: Error | null = null;
+  let wake: (() => void) | null = null;
+
+  const stop = () => {
+    handle?.terminate();
+    handle = null;
+  };
+
+  const onmessage = (message: _FromWorker | Error) => {
+    if (message instanceof Error || 'x' in message) {
+      failure ||= message instanceof Error ? message : new err(message.x);
+      stop();
+      try {
+        controller.error(failure);
+      } catch {}
+    } else if ('c' in message) {
+      if (!failure) controller.enqueue(message.c);
+    } else if ('a' in message) {
+      --inFlight;
+    } else {
+      done = true;
+    }
+    wake?.();
+    wake = null;
+  };
+
+  const wait = async (until: () => boolean) => {
+    while (!until() && !failure) await new Promise<void>((resolve) => (wake = resolve));
+    if (failure) throw failure;
+  };
+
+  const start = () => {
+    handle = idle.pop() || spawn!();
+    handle.onmessage = onmessage;
+    handle.busy(true);
+    const { dictionary, wasmPath, output, lowLatency } = options;
+    handle.post({
+      o: { dictionary, wasmPath, output, lowLatency },
+      // The registered dictionaries, under the IDs their headers declare
+      s: { ..._internal.buffer, dictionaries: [..._loadedDictionaries] },
+    });
+  };
+
+  return new TransformStream<BufferSource, Uint8Array | string>({
+    start(c) {
+      controller = c;
+    },
+
+    async transform(chunk: BufferSource) {
+      if (!handle && !failure) start();
+      await wait(() => inFlight < depth);
+      // Copied into its own ArrayBuffer, the caller may reuse the chunk
+      const data = ArrayBuffer.isView(chunk)
+        ? new Uint8Array(chunk.buffer, chunk.byteOffset, chunk.byteLength).slice()
+        : new Uint8Array(chunk.slice(0));
+      ++inFlight;
+      handle!.post({ c: data }, [data.buffer]);
+    },
+
+    cancel() {
+      failure ||= new err('canceled');
+      stop();
+    },
+
+    async flush() {
+      if (failure) throw failure;
+      if (!handle) start();
+      handle!.post({ e: 1 });
+      await wait(() => done);
+      const worker = handle!;
+      handle = null;
+      worker.busy(false);
+      // Dropped from the idle list if it dies there
+      worker.onmessage = (message) => {
+        if (message instanceof Error && idle.includes(worker)) idle.splice(idle.indexOf(worker), 1);
+      };
+      idle.length < _IDLE_MAX ? idle.push(worker) : worker.terminate();
+    },
+  } as Transformer<BufferSource, Uint8Array | string>);
+};
+
+/**
+ * Worker side: decodes the streams sent by {@link _pipelined}, one at a time, with an in-thread
+ * ZstdDecompressionStream. Returns the message handler.
+ */
+export const _serveStream = (post: (message: _FromWorker, transfer?: Transferable[]) => void) => {
+  let writer: WritableStreamDefaultWriter<BufferSource> | null = null;
+  let drained: Promise<void> = Promise.resolve();
+  let queue: Promise<void> = Promise.resolve();
+  let failed = false;
+
+  const fail = (error: unknown) => {
+    if (failed) return;
+    failed = true;
+    writer = null;
+    post({ x: error instanceof Error ? error.message : String(error) });
+  };
+
+  const handle = async (message: _ToWorker) => {
+    if ('o' in message) {
+      const { dictionaries, ...buffer } = message.s;
+      await setupZstdDecoder(buffer);
+      for (const [id, dict] of dictionaries) _loadedDictionaries.set(id, dict);
+      const stream = new ZstdDecompressionStream({ ...message.o, worker: false });
+      const reader = stream.readable.getReader();
+      writer = stream.writable.getWriter();
+      failed = false;
+      drained = (async () => {
+        for (;;) {
+          const { done, value } = await reader.read();
+          if (done) return;
+          post({ c: value }, _transfer(value));
+        }
+      })();
+      drained.catch(fail);
+      return;
+    }
+    if (!writer) return;
+    try {
+      if ('c' in message) {
+        await writer.write(message.c);
+        post({ a: 1 });
+      } else {
+        await writer.close();
+        await drained;
+        writer = null;
+        post({ d: 1 });
+      }
+    } catch (error) {
+      fail(error);
+    }
+  };
+
+  return (message: _ToWorker) => {
+    queue = queue.then(() => handle(message));
+  };
+};
+
+/**
+ * Web: module Worker running the entrypoint itself (import.meta.url), told apart by its name.
+ * Also serves the stream when the module is loaded in such a worker.
+ */
+export const _setupWebStreamWorker = (url: string): void => {
+  const scope = globalThis as any;
+  if (typeof Worker == 'undefined') return;
+  _installStreamWorker((): _WorkerHandle => {
+    const worker = new Worker(url, { type: 'module', name: _STREAM_WORKER });
+    const handle: _WorkerHandle = {
+      post: (message, transfer) => worker.postMessage(message, transfer || []),
+      busy: () => {},
+      terminate: () => worker.terminate(),
+      onmessage: () => {},
+    };
+    worker.onmessage = (event) => handle.onmessage(event.data);
+    worker.onerror = (event) => handle.onmessage(new Error(event.message));
+    return handle;
+  });
+  if (scope.WorkerGlobalScope && scope.name === _STREAM_WORKER) {
+    const serve = _serveStream((message, transfer) => scope.postMessage(message, transfer || []));
+    scope.onmessage = (event: MessageEvent<_ToWorker>) => serve(event.data);
+  }
+};
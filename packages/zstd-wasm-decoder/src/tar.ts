@@ -0,0 +1,360 @@
+import {
+  _acquireDecoder,
+  _chunks,
+  _getDictId,
+  _HEADER_MAX,
+  _releaseDecoder,
+  type ZstdDecoder,
+} from './shared.js';
+import type { ZstdOptions } from './types.js';
+import { _concatUint8Arrays, err } from './utils.js';
+
+/**
+ * .tar.zst reader on top of the streaming decoder.
+ *
+ * Tar headers (512 byte blocks) are parsed from views of the decoder's output staging area,
+ * copied only when one straddles two flushes. Bodies are copied out to js for the entries being
+ * read: the others (filtered out, or left unread when moving on) are dropped in place. Input is
+ * decoded in bounded steps as entries & bodies are pulled, so memory stays around the window
+ * plus the entry being read instead of the whole archive.
+ * GNU long names (L / K) and pax (x) path, linkpath, size & mtime records are applied.
+ */
+
+export type TarEntryType =
+  | 'file'
+  | 'link'
+  | 'symlink'
+  | 'character'
+  | 'block'
+  | 'directory'
+  | 'fifo'
+  | 'other';
+
+/**
+ * Tar header fields, see {@link TarZstReader}
+ */
+export interface TarHeader {
+  /** Path, with the ustar prefix / long name / pax path applied */
+  name: string;
+  type: TarEntryType;
+  /** Body size in bytes */
+  size: number;
+  mode: number;
+  uid: number;
+  gid: number;
+  /** Modification time, seconds since the epoch */
+  mtime: number;
+  /** Target of links & symlinks */
+  linkname: string;
+}
+
+/**
+ * An archive entry. Its body is decoded as it is read, and only until the next entry is
+ * requested: the rest is then skipped.
+ */
+export interface TarEntry extends TarHeader {
+  /** Body chunks, copied out of wasm memory as they are decoded */
+  body(): AsyncGenerator<Uint8Array>;
+  /** Whole body */
+  bytes(): Promise<Uint8Array>;
+  /** Whole body, UTF-8 decoded */
+  text(): Promise<string>;
+}
+
+/**
+ * Options of {@link TarZstReader}
+ */
+export interface TarZstOptions extends ZstdOptions {
+  /** Entries to yield, the bodies of the others are never copied out (default: all) */
+  filter?: (header: TarHeader) => boolean;
+}
+
+interface _Entry extends TarEntry {
+  _queue: Uint8Array[];
+  // Body bytes not decoded yet
+  _left: number;
+  // Body dropped as decoded (filtered out, or moved past)
+  _skip: boolean;
+}
+
+const _BLOCK = 512;
+// Compressed bytes per decode step: bounds the output decoded ahead of the reader
+const _STEP = 65536;
+
+const _TYPES: Record<number, TarEntryType> = {
+  0: 'file',
+  48: 'file',
+  49: 'link',
+  50: 'symlink',
+  51: 'character',
+  52: 'block',
+  53: 'directory',
+  54: 'fifo',
+  55: 'file',
+};
+
+const _utf8 = /*! @__PURE__ */ new TextDecoder();
+
+// NUL terminated field
+const _str = (h: Uint8Array, off: number, len: number): string => {
+  let end = off;
+  while (end < off + len && h[end]) ++end;
+  return _utf8.decode(h.subarray(off, end));
+};
+
+// Octal field (space / NUL padded), or base-256 when the high bit is set (GNU, large sizes)
+const _num = (h: Uint8Array, off: number, len: number): number => {
+  let n = 0;
+  if (h[off] & 0x80) {
+    n = h[off] & 0x7f;
+    for (let i = off + 1; i < off + len; ++i) n = n * 256 + h[i];
+    return n;
+  }
+  let i = off;
+  while (i < off + len && h[i] == 32) ++i;
+  for (; i < off + len && h[i] >= 48 && h[i] <= 55; ++i) n = n * 8 + h[i] - 48;
+  return n;
+};
+
+const _zero = (h: Uint8Array): boolean => {
+  for (let i = 0; i < _BLOCK; ++i) if (h[i]) return false;
+  return true;
+};
+
+// "<len> <key>=<value>\n" records
+const _pax = (data: Uint8Array, into: Record<string, string>): void => {
+  for (let off = 0; off < data.length; ) {
+    let sp = off;
+    while (sp < data.length && data[sp] != 32) ++sp;
+    const len = Number(_utf8.decode(data.subarray(off, sp)));
+    if (!(len > 0)) return;
+    const record = _utf8.decode(data.subarray(sp + 1, off + len - 1));
+    const eq = record.indexOf('=');
+    if (eq > 0) into[record.slice(0, eq)] = record.slice(eq + 1);
+    off += len;
+  }
+};
+
+/**
+ * Streaming .tar.zst reader: yields the archive entries as they are decoded.
+ *
+ * ```js
+ * for await (const entry of new TarZstReader(response.body, { filter: (h) => h.name.endsWith('.json') })) {
+ *   const json = JSON.parse(await entry.text());
+ * }
+ * ```
+ */
+export class TarZstReader implements AsyncIterable<TarEntry> {
+  private _stream: ReadableStream<BufferSource> | AsyncIterable<BufferSource> | null;
+  private readonly _options: TarZstOptions;
+
+  constructor(
+    stream: ReadableStream<BufferSource> | AsyncIterable<BufferSource>,
+    options: TarZstOptions = {},
+  ) {
+    this._stream = stream;
+    this._options = options;
+  }
+
+  [Symbol.asyncIterator](): AsyncGenerator<TarEntry> {
+    return this.entries();
+  }
+
+  /**
+   * Entries in archive order, single pass
+   */
+  async *entries(): AsyncGenerator<TarEntry> {
+    if (!this._stream) throw new err('tar read twice');
+    const input = _chunks(this._stream);
+    const options = this._options;
+    this._stream = null;
+
+    let decoder: ZstdDecoder | undefined;
+    let idx = -1;
+    let dictId = 0;
+    let first = true;
+    let source = new Uint8Array(0);
+    let srcOff = 0;
+    // Input held back until the frame header (dictionary ID) is complete
+    let head: Uint8Array[] = [];
+    let headLen = 0;
+
+    // Tar state: header bytes of a straddling block, body & padding left of the current entry
+    const hdr = new Uint8Array(_BLOCK);
+    let hdrLen = 0;
+    let remaining = 0;
+    let pad = 0;
+    let zeros = 0;
+    let end = false;
+    let current: _Entry | null = null;
+    // Body of a long name / pax record, applied to the next entry
+    let meta: { flag: number; chunks: Uint8Array[]; len: number } | null = null;
+    let overrides: Record<string, string> = {};
+    const ready: _Entry[] = [];
+
+    const body = async function* (this: _Entry): AsyncGenerator<Uint8Array> {
+      if (this._skip) throw new err('tar entry skipped');
+      for (;;) {
+        while (this._queue.length) yield this._queue.shift()!;
+        if (this._skip) throw new err('tar entry skipped');
+        if (!this._left) return;
+        if (!(await feed())) throw new err('tar truncated');
+      }
+    };
+
+    async function bytes(this: _Entry): Promise<Uint8Array> {
+      const chunks: Uint8Array[] = [];
+      for await (const chunk of this.body()) chunks.push(chunk);
+      return chunks.length ? _concatUint8Arrays(chunks, this.size) : new Uint8Array(0);
+    }
+
+    async function text(this: _Entry): Promise<string> {
+      return _utf8.decode(await this.bytes());
+    }
+
+    const begin = (size: number) => {
+      remaining = size;
+      pad = (_BLOCK - (size % _BLOCK)) % _BLOCK;
+      if (!size) done();
+    };
+
+    const done = () => {
+      if (meta) {
+        const data = _concatUint8Arrays(meta.chunks, meta.len);
+        // L: long name, K: long link name, x: pax record (g, global, is not applied)
+        if (meta.flag == 76) overrides.path = _str(data, 0, data.length);
+        else if (meta.flag == 75) overrides.linkpath = _str(data, 0, data.length);
+        else if (meta.flag == 120) _pax(data, overrides);
+        meta = null;
+      }
+      current = null;
+    };
+
+    const header = (h: Uint8Array) => {
+      if (_zero(h)) {
+        end = ++zeros == 2;
+        return;
+      }
+      zeros = 0;
+      let sum = 0;
+      for (let i = 0; i < _BLOCK; ++i) sum += i >= 148 && i < 156 ? 32 : h[i];
+      if (sum != _num(h, 148, 8)) throw new err('tar checksum');
+
+      const flag = h[156];
+      if (flag == 76 || flag == 75 || flag == 120 || flag == 103) {
+        meta = { flag, chunks: [], len: 0 };
+        return begin(_num(h, 124, 12));
+      }
+      // POSIX ustar: path = prefix/name
+      const ustar = _str(h, 257, 6) == 'ustar' && h[262] == 0;
+      const prefix = ustar ? _str(h, 345, 155) : '';
+      const name = _str(h, 0, 100);
+      const { path, linkpath, size, mtime } = overrides;
+      overrides = {};
+      const entry: _Entry = {
+        name: path ?? (prefix ? `${prefix}/${name}` : name),
+        type: _TYPES[flag] || 'other',
+        size: size ? Number(size) : _num(h, 124, 12),
+        mode: _num(h, 100, 8),
+        uid: _num(h, 108, 8),
+        gid: _num(h, 116, 8),
+        mtime: mtime ? Number(mtime) : _num(h, 136, 12),
+        linkname: linkpath ?? _str(h, 157, 100),
+        body,
+        bytes,
+        text,
+        _queue: [],
+        _left: 0,
+        _skip: false,
+      };
+      // Links, directories & devices have no body, whatever their size field says
+      entry._left = entry.type == 'file' || entry.type == 'other' ? entry.size : 0;
+      entry._skip = !!options.filter && !options.filter(entry);
+      if (!entry._skip) ready.push(entry);
+      current = entry;
+      begin(entry._left);
+    };
+
+    // Output views of wasm memory, only valid during the call
+    const onOutput = (view: Uint8Array) => {
+      const n = view.length;
+      for (let off = 0; off < n && !end; ) {
+        if (remaining) {
+          const take = Math.min(remaining, n - off);
+          const part = view.subarray(off, off + take);
+          if (meta) {
+            meta.chunks.push(part.slice());
+            meta.len += take;
+          } else if (current) {
+            current._left -= take;
+            if (!current._skip) current._queue.push(part.slice());
+          }
+          off += take;
+          remaining -= take;
+          if (!remaining) done();
+        } else if (pad) {
+          const take = Math.min(pad, n - off);
+          off += take;
+          pad -= take;
+        } else if (!hdrLen && n - off >= _BLOCK) {
+          header(view.subarray(off, off + _BLOCK));
+          off += _BLOCK;
+        } else {
+          const take = Math.min(_BLOCK - hdrLen, n - off);
+          hdr.set(view.subarray(off, off + take), hdrLen);
+          hdrLen += take;
+          off += take;
+          if (hdrLen == _BLOCK) {
+            hdrLen = 0;
+            header(hdr);
+          }
+        }
+      }
+    };
+
+    // Decodes one step of input, false once the input (or the archive) is exhausted
+    const feed = async (): Promise<boolean> => {
+      if (end) return false;
+      while (srcOff >= source.length) {
+        const { done, value } = await input.next();
+        if (done && !headLen) return false;
+        if (!done && !decoder) {
+          head.push(value);
+          headLen += value.length;
+          if (headLen < _HEADER_MAX) continue;
+        }
+        source = decoder ? value! : _concatUint8Arrays(head, headLen);
+        srcOff = 0;
+        head = [];
+        headLen = 0;
+      }
+      if (!decoder) [decoder, idx, dictId] = await _acquireDecoder(_getDictId(source), options);
+      const step = source.subarray(srcOff, srcOff + _STEP);
+      srcOff += step.length;
+      decoder._views(step, first, onOutput);
+      first = false;
+      return true;
+    };
+
+    try {
+      for (;;) {
+        while (!ready.length) {
+          if (await feed()) continue;
+          // Cut inside an entry, or inside the zstd frame (a block boundary can fall on a tar one)
+          if (remaining || pad || hdrLen || meta || decoder?._midFrame()) {
+            throw new err('tar truncated');
+          }
+          return;
+        }
+        const entry = ready.shift()!;
+        yield entry;
+        // Moving on: the rest of the body is dropped as decoded
+        entry._skip = true;
+        entry._queue.length = 0;
+      }
+    } finally {
+      if (decoder) idx == -1 ? decoder._destroy() : _releaseDecoder(idx, dictId);
+      await input.return(undefined);
+    }
+  }
+}
@@ -27,8 +27,60 @@ export interface DecoderWasmExports extends BaseWasmExports {
   /** Decompresses a stream of data */
   ds(): number;
 
-  /** Resets the decompression context */
+  /**
+   * Streams a whole staged input through ds(), output goes to the imported env.emit. Returns
+   * the error code, or 1 when the stream stopped inside a frame
+   */
+  dl(srcPtr: number, srcSize: number, flushAt: number, final: number): number;
+
+  /** Pointer to the entropy table cache counters (4 x u32) */
+  tc(): number;
+
+  /** Output fingerprint mode (0 off, 1 XXH3-64, 2 XXH3-128), resets it. Returns 0 without XXH3 */
+  fp(mode: number): number;
+
+  /** Digests the output fingerprint, pointer to { low64, high64 } */
+  fd(): number;
+
+  /** Record delimiter byte scanned in flushed output (-1 off), pointer to { count, off[4096] } (u32) */
+  rd(delim: number): number;
+
+  /** Resets the decompression context, releases the stream arena */
   re(): number;
+
+  /** Carves the stream context's arena (size bytes) out of the heap, returns its base */
+  sa(size: number): number;
+
+  /** Stream arena mark (its cursor) */
+  am(): number;
+
+  /** Releases the stream arena back to a mark */
+  ar(mark: number): void;
+
+  /** Lists the memory regions of the stream state, pointer to { count, cursor, { ptr, len }[8] } (u32) */
+  ck(): number;
+
+  /** Memory high-water mark, pointer to { heap cursor, stream arena cursor, peak } (u32). reset restarts the peak */
+  hw(reset: number): number;
+
+  /** Pointer to the stream's ZSTD_outBuffer struct { dst, size, pos } (u32) */
+  ob(): number;
+
+  /** Relocatable build: applies the static data relocations against __memory_base */
+  __wasm_apply_data_relocs?(): void;
+}
+
+/**
+ * Region of a host owned memory for the relocatable build (zstd-decoder-pic.wasm), see
+ * ZstdDecoder.init
+ */
+export interface DecoderMemory {
+  /** Memory shared with the host, and with other decoders in their own regions */
+  memory: WebAssembly.Memory;
+  /** Start of the region, 16 byte aligned */
+  base: number;
+  /** Region size in bytes (default: 16 MB, see calibrateMemory) */
+  size?: number;
 }
 
 /**
@@ -43,6 +95,19 @@ export interface DecoderOptions {
 
   /** Maximum (decompressed) buffer size in bytes */
   maxDstSize?: number;
+
+  /**
+   * Input step & output flush sizes of decompressStream: split per stream from the observed
+   * compression ratio and the frame's block size ('adaptive', default), or the historic
+   * constants ('fixed': 256 KB steps, flushes every 640 KB)
+   */
+  streamSizing?: 'adaptive' | 'fixed';
+
+  /**
+   * XXH3 of the decompressed output, hashed in wasm while still in cache: returned by
+   * fingerprint() after decompressSync, and with the decompressStream results (off by default)
+   */
+  fingerprint?: 'xxh3-64' | 'xxh3-128';
 }
 
 /**
@@ -56,6 +121,41 @@ export interface ZstdOptions {
   wasmPath?: string;
 }
 
+/**
+ * Options of ZstdDecompressionStream.
+ */
+export interface ZstdStreamOptions extends ZstdOptions {
+  /**
+   * Decode in a dedicated worker (worker_threads in Node, a module Worker on the web), overlapping
+   * decoding with the consumer of the output. Ignored where workers are unavailable (Cloudflare Workers).
+   */
+  worker?: boolean;
+
+  /** Compressed chunks in flight to the worker before writes wait (default: 4) */
+  queueDepth?: number;
+
+  /**
+   * 'text': the readable side yields strings, UTF-8 decoded straight from wasm memory across
+   * chunk boundaries (default: 'bytes', Uint8Array chunks)
+   */
+  output?: 'bytes' | 'text';
+
+  /**
+   * Start decoding as soon as the frame header is in, instead of gathering 256 KB (or the frame's
+   * window) of input first: output follows the input block by block (time to first byte), at
+   * the cost of more, smaller decoder calls
+   */
+  lowLatency?: boolean;
+}
+
+/**
+ * Options of decodeRecords.
+ */
+export interface ZstdRecordOptions extends ZstdOptions {
+  /** Record delimiter byte (default: 0x0a, NDJSON / line-delimited output) */
+  delimiter?: number;
+}
+
 /**
  * Result from a streaming decompression operation.
  */
@@ -65,4 +165,132 @@ export interface StreamResult {
 
   /** Offset into the input buffer indicating how much was consumed */
   in_offset: number;
+
+  /** XXH3 of the stream's output so far, with the fingerprint option */
+  fingerprint?: bigint;
+}
+
+/**
+ * Entropy table cache counters of a decoder instance, cumulative. A hit reuses the Huffman or
+ * FSE table built for an earlier frame with a byte-identical header instead of rebuilding it.
+ */
+export interface TableCacheStats {
+  /** Huffman literal tables */
+  huffman: { hits: number; misses: number };
+
+  /** FSE sequence tables (literal lengths, offsets, match lengths) */
+  fse: { hits: number; misses: number };
+}
+
+/**
+ * Runtime native zstd (node:zlib, Bun), registered by the entrypoint for the hybrid dispatcher.
+ */
+export interface NativeZstdProvider {
+  /** Provider name, reported in metrics and stored with a calibration */
+  name: string;
+
+  /** Whether dictionaries can be passed through */
+  dict: boolean;
+
+  /** Single frame decompression, may throw above maxDstSize (checked again by the dispatcher) */
+  sync(input: Uint8Array, maxDstSize: number, dictionary?: Uint8Array): Uint8Array;
+
+  /** Same, off the calling thread where the runtime supports it */
+  async(input: Uint8Array, maxDstSize: number, dictionary?: Uint8Array): Promise<Uint8Array>;
+
+  /** Used to build calibration samples when none are given */
+  compress?(input: Uint8Array): Uint8Array;
+}
+
+/**
+ * Routing table of the hybrid dispatcher. One character per input size class
+ * (<1k, <4k, <16k, <64k, <256k, <1m, <4m, >=4m compressed bytes): `w` wasm, `n` native.
+ */
+export interface HybridCalibration {
+  /** Provider the table was measured against */
+  provider: string;
+
+  /** Routes for decompressSync */
+  sync: string;
+
+  /** Routes for decompress */
+  async: string;
+}
+
+/**
+ * Routing decisions of the hybrid dispatcher since setup.
+ */
+export interface HybridMetrics {
+  /** Active provider, empty if the runtime has none */
+  provider: string;
+
+  /** Active routing table (persist it and pass it back to setupHybridDecoder to skip calibration) */
+  calibration: HybridCalibration | null;
+
+  /** decompressSync calls per size class routed to [wasm, native] */
+  sync: number[][];
+
+  /** decompress calls per size class routed to [wasm, native] */
+  async: number[][];
+
+  /** Native failures replayed on wasm (errors are always reported by wasm) */
+  fallbacks: number;
+}
+
+/**
+ * Memory needs measured by calibrateMemory. maxSrcSize & maxDstSize can be passed to
+ * setupZstdDecoder as is, the whole object persisted as JSON.
+ */
+export interface MemoryCalibration {
+  /** Largest compressed sample, x2 rounded up to a power of two */
+  maxSrcSize: number;
+
+  /** Largest decoded sample, x2 rounded up to a power of two */
+  maxDstSize: number;
+
+  /** Region size the samples need with the relocatable build (DecoderMemory.size), 64 KB pages */
+  memorySize: number;
+
+  /** Whether the small window build (2 MB memory) decodes all samples */
+  small: boolean;
+
+  /** Per window size (frame header) seen: frames, high-water marks in bytes */
+  windows: Array<{ windowSize: number; frames: number; memory: number; arena: number }>;
+}
+
+/**
+ * Options of the decompressed result cache, see setupResultCache.
+ */
+export interface ResultCacheOptions {
+  /** Byte budget (compressed + decompressed) of the cached entries, 0 disables & clears the cache */
+  maxBytes: number;
+
+  /**
+   * Return the cached output itself instead of a copy. It is shared between all callers
+   * decoding the same input and must be treated as read-only (default: false)
+   */
+  shared?: boolean;
+}
+
+/**
+ * Decompressed result cache counters, since setupResultCache.
+ */
+export interface ResultCacheStats {
+  /** Calls answered from the cache */
+  hits: number;
+
+  /** Calls decoded (and cached when they fit the budget) */
+  misses: number;
+
+  /** hits / (hits + misses), 0 before the first call */
+  hitRate: number;
+
+  /** Cached entries */
+  entries: number;
+
+  /** Bytes held (compressed + decompressed) */
+  bytes: number;
+
+  /** Byte budget */
+  maxBytes: number;
 }
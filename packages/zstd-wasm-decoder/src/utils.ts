@@ -19,13 +19,42 @@ export const rb = /*! @__PURE__ */ (d: Uint8Array, b: number, n: number) => {
   return o;
 };
 
+// Frame content size, 0 if not declared
 export const _fss = (dat: Uint8Array): number => {
   const flg = dat[4];
   const ss = (flg >> 5) & 1,
     df = flg & 3,
     fcf = flg >> 6;
-  // @ts-expect-error
-  return rb(dat, 6 - ss + df == 3 ? 4 : df, fcf ? 1 << fcf : ss) + (fcf == 1 && 256);
+  const p = 6 - ss + (df == 3 ? 4 : df);
+  // 8 byte field: rb only reads 32 bits
+  if (fcf == 3) return (rb(dat, p, 4) >>> 0) + (rb(dat, p + 4, 4) >>> 0) * 2 ** 32;
+  return (rb(dat, p, fcf ? 1 << fcf : ss) >>> 0) + (fcf == 1 ? 256 : 0);
+};
+
+// Block_Maximum_Size of the frame at offset 0: min(window size, 128 KB), 128 KB if unknown
+export const _bsm = (dat: Uint8Array): number => {
+  if (dat.length < 6 || (dat[0] | (dat[1] << 8) | (dat[2] << 16)) != 0x2fb528 || dat[3] != 253) return 131072;
+  if ((dat[4] >> 5) & 1) return Math.min(_fss(dat) || 131072, 131072);
+  const wb = 1 << (10 + (dat[5] >> 3));
+  return Math.min(wb + (wb >> 3) * (dat[5] & 7), 131072);
+};
+
+// Compressed size of the frame at offset 0 (ZSTD_findFrameCompressedSize), -1 if truncated.
+// Only walks the 3 byte block headers.
+export const _fcs = (dat: Uint8Array): number => {
+  const flg = dat[4];
+  const ss = (flg >> 5) & 1,
+    df = flg & 3,
+    fcf = flg >> 6;
+  let p = 6 - ss + (df == 3 ? 4 : df) + (fcf ? 1 << fcf : ss);
+  for (let bh = 0; !(bh & 1); ) {
+    if (p + 3 > dat.length) return -1;
+    bh = dat[p] | (dat[p + 1] << 8) | (dat[p + 2] << 16);
+    // RLE blocks carry a single byte
+    p += 3 + (((bh >> 1) & 3) == 1 ? 1 : bh >> 3);
+  }
+  if ((flg >> 2) & 1) p += 4;
+  return p > dat.length ? -1 : p;
 };
 
 // Read Zstandard frame header
@@ -68,3 +97,20 @@ export function _concatUint8Arrays(arrays: Uint8Array[], ol: number): Uint8Array
   }
   return buf;
 }
+
+// 32 bit hash of the whole buffer (murmur3 mixing, 4 bytes a step), seeded
+export const _h32 = (dat: Uint8Array, seed: number): number => {
+  const n = dat.length;
+  const e = n & ~3;
+  let h = seed ^ n;
+  for (let i = 0; i < e; i += 4) {
+    let k = dat[i] | (dat[i + 1] << 8) | (dat[i + 2] << 16) | (dat[i + 3] << 24);
+    k = Math.imul(k, 0xcc9e2d51);
+    h ^= Math.imul((k << 15) | (k >>> 17), 0x1b873593);
+    h = Math.imul((h << 13) | (h >>> 19), 5) + 0xe6546b64;
+  }
+  for (let i = e; i < n; ++i) h = Math.imul(h ^ dat[i], 0x01000193);
+  h = Math.imul(h ^ (h >>> 16), 0x85ebca6b);
+  h = Math.imul(h ^ (h >>> 13), 0xc2b2ae35);
+  return (h ^ (h >>> 16)) >>> 0;
+};
@@ -0,0 +1,34 @@
+// Exports of the web entries (index.web.ts, index.web.perf.ts). No wasm URL here: each entry sets
+// the loader of its own build, so a bundler only emits the wasm of the entry in use
+
+// biome-ignore lint/performance/noBarrelFile: exports of the entrypoints
+export {
+  calibrateMemory,
+  createDecoder,
+  decodeRecords,
+  decompress,
+  decompressStream,
+  decompressSync,
+  decompressToString,
+  getResultCacheStats,
+  setupResultCache,
+  setupZstdDecoder,
+  ZstdDecoder,
+  ZstdDecompressionStream,
+} from './shared.js';
+
+export { decodeZstdResponse } from './response.js';
+export { TarZstReader } from './tar.js';
+export type { TarEntry, TarEntryType, TarHeader, TarZstOptions } from './tar.js';
+
+export type {
+  DecoderMemory,
+  DecoderOptions,
+  MemoryCalibration,
+  ResultCacheOptions,
+  ResultCacheStats,
+  StreamResult,
+  TableCacheStats,
+  ZstdRecordOptions,
+  ZstdStreamOptions,
+} from './types.js';
@@ -0,0 +1,184 @@
+import type { DecoderOptions, StreamResult, TableCacheStats } from './types.js';
+import { _fss, err } from './utils.js';
+import { _MAX_DST_BUF, _MAX_SRC_BUF } from './zstd-wasm.js';
+
+/**
+ * Node only: same surface & limits as ZstdDecoder, backed by the native addon (`make native`,
+ * bin/zstd_native.c) instead of a wasm instance. One native ZSTD_DCtx (+ DDict) per decoder.
+ */
+export interface NativeBinding {
+  create(dictionary?: Uint8Array): object;
+  dS(handle: object, src: Uint8Array, dstCapacity: number): Uint8Array;
+  ds(handle: object, src: Uint8Array, reset: boolean, maxDstSize: number): Uint8Array;
+  mf(handle: object): boolean;
+}
+
+const _STREAM_RESULT: StreamResult = { buf: new Uint8Array(0), in_offset: 0 };
+const _utf8 = /*! @__PURE__ */ new TextDecoder();
+
+class ZstdNativeDecoder {
+  private _binding!: NativeBinding;
+  private _handle!: object;
+
+  private readonly _dictionary?: Uint8Array;
+  private readonly _maxSrcSize: number = 0;
+  private readonly _maxDstSize: number = 0;
+  private readonly _fingerprint: boolean;
+  private _delimiter = -1;
+
+  constructor(options: DecoderOptions = {}) {
+    this._dictionary = options.dictionary
+    this._fingerprint = !!options.fingerprint;
+    this._maxSrcSize = Math.max(options.maxSrcSize!, _MAX_DST_BUF << 6)
+    this._maxDstSize = Math.max(options.maxDstSize!, _MAX_DST_BUF << 6)
+  }
+
+  /**
+   * Initialize with the loaded addon
+   */
+  init(binding: NativeBinding): ZstdNativeDecoder {
+    if (this._fingerprint) throw new err('no xxh3');
+    if (this._dictionary && this._dictionary.length > _MAX_SRC_BUF) {
+      throw new err('dict>2mb');
+    }
+    this._binding = binding;
+    this._handle = binding.create(this._dictionary);
+    return this;
+  }
+
+  /**
+   * Same as ZstdDecoder.decompressSync: single pass up to 9.37 MB, streaming above
+   */
+  decompressSync(compressedData: Uint8Array, expectedSize?: number): Uint8Array {
+    if (!this._handle) throw new err('not init');
+
+    const srcSize = compressedData.length;
+
+    if (srcSize > this._maxSrcSize) {
+      throw new err(`comp dat>maxSrcSize lim`);
+    }
+
+    if (!expectedSize) expectedSize = _fss(compressedData);
+
+    if (expectedSize > _MAX_DST_BUF || srcSize > _MAX_SRC_BUF) {
+      return this.decompressStream(compressedData, true).buf;
+    }
+
+    return this._binding.dS(this._handle, compressedData, _MAX_DST_BUF);
+  }
+
+  /**
+   * Same as ZstdDecoder.decompressView, the addon's output is already a buffer of its own
+   */
+  decompressView(compressedData: Uint8Array, expectedSize?: number): Uint8Array {
+    return this.decompressSync(compressedData, expectedSize);
+  }
+
+  /**
+   * Not supported: the addon reads its input from js buffers
+   */
+  inputBuffer(): Uint8Array {
+    throw new err('no input buffer');
+  }
+
+  /**
+   * Same as ZstdDecoder.decompressToString (decoded from the addon's output buffer)
+   */
+  decompressToString(compressedData: Uint8Array, expectedSize?: number): string {
+    return _utf8.decode(this.decompressSync(compressedData, expectedSize));
+  }
+
+  /**
+   * Same as ZstdDecoder._views (the addon's output buffers)
+   */
+  _views(input: Uint8Array, reset: boolean, emit: (chunk: Uint8Array) => void): void {
+    this.decompressStream(input, reset, emit);
+  }
+
+  /**
+   * Same as ZstdDecoder._text
+   */
+  _text(input: Uint8Array, reset: boolean, text: TextDecoder): string {
+    return text.decode(this.decompressStream(input, reset).buf, { stream: true });
+  }
+
+  /**
+   * Same as ZstdDecoder.decompressStream - can be fed chunks incrementally
+   */
+  decompressStream(
+    input: Uint8Array,
+    reset = false,
+    emit?: (chunk: Uint8Array, records?: Uint32Array) => void,
+  ): StreamResult {
+    if (!this._handle) throw new err('not init');
+
+    const inLen = input.length || 0;
+    if (inLen == 0) {
+      if (reset) this._binding.ds(this._handle, input, true, this._maxDstSize);
+      return _STREAM_RESULT;
+    }
+
+    const buf = this._binding.ds(this._handle, input, reset, this._maxDstSize);
+    if (!emit) return { buf, in_offset: inLen };
+    if (buf.length > 0) this._delimiter < 0 ? emit(buf) : emit(buf, this._records(buf));
+    return { buf: _STREAM_RESULT.buf, in_offset: inLen };
+  }
+
+  /**
+   * Same as ZstdDecoder._midFrame
+   */
+  _midFrame(): boolean {
+    return this._binding.mf(this._handle);
+  }
+
+  /**
+   * Same as ZstdDecoder.recordDelimiter, scanned in js
+   */
+  recordDelimiter(byte?: number): void {
+    this._delimiter = byte === undefined ? -1 : byte & 255;
+  }
+
+  private _records(buf: Uint8Array): Uint32Array {
+    const offsets: number[] = [];
+    for (let i = buf.indexOf(this._delimiter); i != -1; i = buf.indexOf(this._delimiter, i + 1)) {
+      offsets.push(i);
+    }
+    return Uint32Array.from(offsets);
+  }
+
+  /**
+   * The native build has no entropy table cache
+   */
+  tableCacheStats(): TableCacheStats {
+    return { huffman: { hits: 0, misses: 0 }, fse: { hits: 0, misses: 0 } };
+  }
+
+  /**
+   * The native build does not hash its output
+   */
+  fingerprint(): bigint {
+    throw new err('no xxh3');
+  }
+
+  /**
+   * Not supported: the addon's stream state lives in native heap allocations
+   */
+  checkpoint(): Uint8Array {
+    throw new err('no checkpoint');
+  }
+
+  restore(_snapshot: Uint8Array): void {
+    throw new err('no checkpoint');
+  }
+
+  /**
+   * Native context is released once the handle is collected
+   */
+  _destroy(): void {
+    //@ts-expect-error gc.
+    this._binding = this._handle = null;
+  }
+}
+
+export default ZstdNativeDecoder;
+export { ZstdNativeDecoder };
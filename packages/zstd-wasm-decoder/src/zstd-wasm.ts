@@ -1,5 +1,11 @@
-import type { DecoderWasmExports, DecoderOptions, StreamResult } from './types.js';
-import { _fss, err, _concatUint8Arrays } from './utils.js';
+import type {
+  DecoderMemory,
+  DecoderWasmExports,
+  DecoderOptions,
+  StreamResult,
+  TableCacheStats,
+} from './types.js';
+import { _bsm, _fss, _h32, err, _concatUint8Arrays } from './utils.js';
 /**
  * ╔══════════════════════════════════════════════════════════════╗
  * ║                        Memory Layout                         ║
@@ -29,7 +35,10 @@ import { _fss, err, _concatUint8Arrays } from './utils.js';
  * ║            │   Read-only constants  2208b       │            ║
  * ║  0x19f00   ├────────────────────────────────────┤            ║
  * ║            │   ZSTD_DDict Ptr    (4b)           │            ║
- * ║  0x19f04   ├────────────────────────────────────┤            ║
+ * ║  0x20000   ├────────────────────────────────────┤            ║
+ * ║            │   Entropy table cache (~106 KB)    │            ║
+ * ║            │   (Huffman / FSE tables, 4 each)   │            ║
+ * ║  0x3a980   ├────────────────────────────────────┤            ║
  * ║            │   Dictionary (optional)            │            ║
  * ║            │   (up to 2 MB)                     │            ║
  * ║            │   (only allocated if provided)     │            ║
@@ -44,7 +53,7 @@ import { _fss, err, _concatUint8Arrays } from './utils.js';
  * ║            │  (384KB) + 64 bytes                │            ║
  * ║  +9.4MB    └────────────────────────────────────┘            ║
  * ║                                                              ║
- * ║ Total: ~13.5 MB (with dict), ~11.5 MB (without dict)         ║
+ * ║ Total: ~13.6 MB (with dict), ~11.6 MB (without dict)         ║
  * ╠══════════════════════════════════════════════════════════════╣
  * ║                         Notes                                ║
  * ╠══════════════════════════════════════════════════════════════╣
@@ -68,6 +77,48 @@ import { _fss, err, _concatUint8Arrays } from './utils.js';
  * ║   but we size the initial allocation to handle most common   ║
  * ║   cases without heap growth needed at all                    ║
  * ╚══════════════════════════════════════════════════════════════╝
+ *
+ * ╔══════════════════════════════════════════════════════════════╗
+ * ║            Small window build (make small, 2 MB)             ║
+ * ╠══════════════════════════════════════════════════════════════╣
+ * ║   0x0000   ┌────────────────────────────────────┐            ║
+ * ║            │  Stack, stream structs, DCtx,      │            ║
+ * ║            │  constants (as above, ~104 KB)     │            ║
+ * ║  0x19f04   ├────────────────────────────────────┤            ║
+ * ║            │   Dictionary (optional, 256 KB)    │            ║
+ * ║            ├────────────────────────────────────┤            ║
+ * ║            │    Source Buffer (160 KB)          │            ║
+ * ║            │    64 KB input / 96 KB output      │            ║
+ * ║            │    staging when streaming          │            ║
+ * ║            ├────────────────────────────────────┤            ║
+ * ║            │    Destination Buffer (rest)       │            ║
+ * ║            │  Streaming: windowSize (1 MB)      │            ║
+ * ║            │  + 3*blockSize (384KB) + 64 bytes  │            ║
+ * ║    2 MB    └────────────────────────────────────┘            ║
+ * ║                                                              ║
+ * ║ • Detected from the memory size at init. Frames with windows ║
+ * ║   above 1 MB are refused when streamed ('win>1mb lim'),      ║
+ * ║   single pass only needs the output to fit                   ║
+ * ╚══════════════════════════════════════════════════════════════╝
+ *
+ * ╔══════════════════════════════════════════════════════════════╗
+ * ║     Relocatable build (make pic), region at base in the      ║
+ * ║     host's memory: init(module, { memory, base, size })      ║
+ * ╠══════════════════════════════════════════════════════════════╣
+ * ║   base     ┌────────────────────────────────────┐            ║
+ * ║            │  Static data (dylink.0 size):      │            ║
+ * ║            │  stream structs, DCtx, constants   │            ║
+ * ║            ├────────────────────────────────────┤            ║
+ * ║            │      Stack Space (8 KB)            │            ║
+ * ║            ├────────────────────────────────────┤            ║
+ * ║            │  Table cache, dictionary, source & │            ║
+ * ║            │  destination buffers (as above)    │            ║
+ * ║ base+size  └────────────────────────────────────┘            ║
+ * ║                                                              ║
+ * ║ • 16 MB by default (frames up to level 19), or sized from    ║
+ * ║   calibrateMemory. Regions must not overlap, and the memory  ║
+ * ║   must not grow while decoders use it                        ║
+ * ╚══════════════════════════════════════════════════════════════╝
  */
 
 /**
@@ -95,14 +146,67 @@ import { _fss, err, _concatUint8Arrays } from './utils.js';
  */
 
 export const _MAX_SRC_BUF = 2 * 1024 * 1024; // 2 MB input buffer
-const _MAX_DST_BUF = 9830464; // 9.37 MB
+export const _MAX_DST_BUF = 9830464; // 9.37 MB
+// Small window build, ZSTD_WASM_MAX_WINDOW_SIZE = 1 MB (+1)
+export const _SMALL_MEMORY = 2 * 1024 * 1024;
+const _SMALL_SRC_BUF = 163840;
+// Stream arena of the small build, without a dictionary: memory past the heap start & src area
+export const _SMALL_ARENA = _SMALL_MEMORY - 131072 - _SMALL_SRC_BUF;
+// What a dictionary takes from it besides its bytes: the ZSTD_DDict cd() allocates (27324 bytes)
+export const _DDICT_SIZE = 27648;
+const _SMALL_MAX_DICT = 262144;
+// ZSTD_error_frameParameter_windowTooLarge
+const _WINDOW_TOO_LARGE = -16;
 const _STREAM_RESULT: StreamResult = { buf: new Uint8Array(0), in_offset: 0 };
-const _streamInputStructPtr = 8192;
-const _streamOutputStructPtr = 8208;
+const _utf8 = /*! @__PURE__ */ new TextDecoder();
+// Relocatable build: default region, stack below the heap
+const _REGION = 16 * 1024 * 1024;
+const _STACK = 8192;
+// Decoded / compressed ratio a stream starts from, before anything was observed
+const _PRIOR_RATIO = 6;
+// Checkpoint: 'ZCK1', header of 11 u32 + 2 f64 (stream byte counts), then { ptr, len, bytes }[]
+const _CK_MAGIC = 0x314b435a;
+const _CK_HEADER = 60;
+
+// Output sink of the running dl() call: emit(ptr, len) is imported by every instance,
+// and stream calls are synchronous, so the current decoder installs its own around dl()
+let _sink: (ptr: number, len: number) => void = () => {};
+export const _imports = { env: { emit: (ptr: number, len: number) => _sink(ptr, len) } };
+
+// dylink.0 memory info of the relocatable build: [data size, data alignment (log2), table size]
+const _dylink = (module: WebAssembly.Module): number[] => {
+  const [section] = WebAssembly.Module.customSections(module, 'dylink.0');
+  if (!section) throw new err('not pic');
+  const b = new Uint8Array(section);
+  let off = 0;
+  const leb = () => {
+    let value = 0;
+    for (let shift = 0; ; shift += 7) {
+      const byte = b[off++];
+      value += (byte & 0x7f) * 2 ** shift;
+      if (byte < 0x80) return value;
+    }
+  };
+  while (off < b.length) {
+    const type = b[off++];
+    const end = leb() + off;
+    // WASM_DYLINK_MEM_INFO
+    if (type == 1) return [leb(), leb(), leb()];
+    off = end;
+  }
+  return [0, 0, 0];
+};
 class ZstdDecoder {
   private _exports!: DecoderWasmExports;
   private _HEAPU8!: Uint8Array;
   private _HEAPU32!: Uint32Array;
+  // SharedArrayBuffer backed (pic-shared): TextDecoder only takes copies
+  private _shared = false;
+  // Region of this decoder: the whole memory, or [base, base + size) of the host's (pic)
+  private _base = 0;
+  private _size = 0;
+  // ZSTD_outBuffer struct (ob())
+  private _outStruct = 0;
 
   private readonly _dictionary?: Uint8Array;
   private readonly _maxSrcSize: number = 0;
@@ -114,21 +218,71 @@ class ZstdDecoder {
   private _srcPtr: number = 0;
   private _dstPtr: number = 0;
 
+  // Buffer sizes, per build (see the layouts above)
+  private _small = false;
+  private _srcBuf: number = _MAX_SRC_BUF;
+  private _dstBuf: number = _MAX_DST_BUF;
+  private _inChunk = 262150;
+  private _outCap = 917501;
+  private _outFlush = 655360;
+
+  // Adaptive stream sizing: block size of the current frame, bytes in / out of the current stream
+  private readonly _adaptive: boolean;
+  private _bsm = 131072;
+  private _streamIn = 0;
+  private _streamOut = 0;
+
+  // Output fingerprint: 0 off, 1 XXH3-64, 2 XXH3-128 (the fp() modes)
+  private readonly _fp: number;
+  // Record boundaries: u32 index of the rd() offsets struct { count, off[] }, 0 when off
+  private _rd = 0;
+  // emit receives views of wasm memory instead of copies (_views)
+  private _view = false;
+
   constructor(options: DecoderOptions = {}) {
     this._dictionary = options.dictionary
+    this._adaptive = options.streamSizing != 'fixed';
+    this._fp = options.fingerprint ? (options.fingerprint == 'xxh3-128' ? 2 : 1) : 0;
     this._maxSrcSize = Math.max(options.maxSrcSize!, _MAX_DST_BUF << 6)
     this._maxDstSize = Math.max(options.maxDstSize!, _MAX_DST_BUF << 6)
   }
 
   /**
-   * Initialize with a compiled WebAssembly module
+   * Initialize with a compiled WebAssembly module. With a memory region, the module is the
+   * relocatable build (zstd-decoder-pic.wasm) and runs in the host's memory: several decoders
+   * can share one WebAssembly.Memory, each in its own region.
    */
-  init(wasmModule: WebAssembly.Module): ZstdDecoder {
-    return this._initCommon(new WebAssembly.Instance(wasmModule, { env: {} }));
+  init(wasmModule: WebAssembly.Module, region?: DecoderMemory): ZstdDecoder {
+    if (!region) return this._initCommon(new WebAssembly.Instance(wasmModule, _imports));
+
+    const { memory, base } = region;
+    const size = region.size || _REGION;
+    const [dataSize, align, tableSize] = _dylink(wasmModule);
+    if (base % 2 ** Math.max(align, 4) || base + size > memory.buffer.byteLength) {
+      throw new err('bad region');
+    }
+    // Stack right after the static data, the heap after it
+    const stackTop = base + ((dataSize + 15) & ~15) + _STACK;
+    const instance = new WebAssembly.Instance(wasmModule, {
+      env: {
+        ..._imports.env,
+        memory,
+        __memory_base: base,
+        // Index 0 stays empty: a function pointer never equals NULL
+        __table_base: 1,
+        __stack_pointer: new WebAssembly.Global({ value: 'i32', mutable: true }, stackTop),
+        __indirect_function_table: new WebAssembly.Table({ initial: tableSize + 1, element: 'anyfunc' }),
+      },
+    });
+    const exports = instance.exports as unknown as DecoderWasmExports;
+    // Pointers in static data, against __memory_base (the shared memory build does it at start)
+    exports.__wasm_apply_data_relocs?.();
+    exports.pb(stackTop);
+    return this._initCommon(instance, memory, base, size);
   }
 
   /**
-   * Initialize with an existing WebAssembly instance
+   * Initialize with an existing WebAssembly instance (instantiated with _imports)
    */
   _initWithInstance(
     wasmInstance: WebAssembly.Instance,
@@ -137,27 +291,52 @@ class ZstdDecoder {
     return this._initCommon(wasmInstance);
   }
 
-  private _initCommon(wasmInstance: WebAssembly.Instance): ZstdDecoder {
+  private _initCommon(
+    wasmInstance: WebAssembly.Instance,
+    memory?: WebAssembly.Memory,
+    base = 0,
+    size = 0,
+  ): ZstdDecoder {
     this._exports = wasmInstance.exports as unknown as DecoderWasmExports;
-    const _memory = this._exports.memory as WebAssembly.Memory;
+    const _memory = memory || (this._exports.memory as WebAssembly.Memory);
 
     this._HEAPU8 = new Uint8Array(_memory.buffer);
     this._HEAPU32 = new Uint32Array(_memory.buffer);
+    this._shared =
+      typeof SharedArrayBuffer != 'undefined' && _memory.buffer instanceof SharedArrayBuffer;
+    this._base = base;
+    this._size = size || _memory.buffer.byteLength;
 
     this._exports._initialize();
+    if (this._fp && !this._exports.fp(this._fp)) throw new err('no xxh3');
+    this._outStruct = this._exports.ob();
+
+    // Small window build: same code, smaller fixed memory
+    if (!memory && _memory.buffer.byteLength <= _SMALL_MEMORY) {
+      this._small = true;
+      this._srcBuf = _SMALL_SRC_BUF;
+      this._inChunk = 65536;
+      this._outCap = _SMALL_SRC_BUF - 65536;
+      this._outFlush = 65536;
+    }
 
     // Initialize dictionary if provided
     if (this._dictionary) {
       const _dictLen = this._dictionary.length;
-      if (_dictLen > _MAX_SRC_BUF) {
-        throw new err('dict>2mb');
+      if (_dictLen > (this._small ? _SMALL_MAX_DICT : _MAX_SRC_BUF)) {
+        throw new err(this._small ? 'dict>256kb' : 'dict>2mb');
       }
       const dictPtr = this._exports.malloc(_dictLen);
       this._HEAPU8.set(this._dictionary as Uint8Array, dictPtr);
       this._exports.cd(dictPtr, _dictLen);
     }
-    this._srcPtr = this._exports.malloc(_MAX_SRC_BUF);
-    this._dstPtr = this._srcPtr + _MAX_SRC_BUF; // We don't malloc dst buf. Its where dst buf starts. Zstd will malloc
+    this._srcPtr = this._exports.malloc(this._srcBuf);
+    // The rest of the region is the stream context's arena: single pass output, or the stream's
+    // window & input buffers (allocated by ds(), released by re())
+    this._dstPtr = this._exports.sa(base + this._size - this._srcPtr - this._srcBuf);
+    this._dstBuf = Math.min(_MAX_DST_BUF, base + this._size - this._dstPtr);
+    // Frames needing more than the stream arena fail with dec err -64 (memory_allocation)
+    if (this._dstBuf <= 0) throw new err('region too small');
     return this;
   }
 
@@ -171,6 +350,49 @@ class ZstdDecoder {
    * @returns Decompressed data
    */
   decompressSync(compressedData: Uint8Array, expectedSize?: number): Uint8Array {
+    const size = this._single(compressedData, expectedSize);
+    if (size < 0) return this.decompressStream(compressedData, true).buf;
+    return this._HEAPU8.slice(this._dstPtr, this._dstPtr + size);
+  }
+
+  /**
+   * Same as decompressSync, returning a view of the decoder's destination area instead of a copy,
+   * valid until the next call on this decoder. With a shared memory (pic-shared) the view can be
+   * posted to workers as is. Output needing streaming is returned as a new buffer.
+   */
+  decompressView(compressedData: Uint8Array, expectedSize?: number): Uint8Array {
+    const size = this._single(compressedData, expectedSize);
+    if (size < 0) return this.decompressStream(compressedData, true).buf;
+    return this._HEAPU8.subarray(this._dstPtr, this._dstPtr + size);
+  }
+
+  /**
+   * The decoder's source area: input read (e.g. by the host's I/O) into its start and passed to
+   * decompressSync / decompressView as a view of it is not copied again
+   */
+  inputBuffer(): Uint8Array {
+    if (!this._exports) throw new err('not init');
+    return this._HEAPU8.subarray(this._srcPtr, this._srcPtr + this._srcBuf);
+  }
+
+  /**
+   * Same as decompressSync, UTF-8 decoded straight from wasm memory: no intermediate output buffer
+   */
+  decompressToString(compressedData: Uint8Array, expectedSize?: number): string {
+    const size = this._single(compressedData, expectedSize);
+    if (size < 0) {
+      const text = new TextDecoder();
+      return this._text(compressedData, true, text) + text.decode();
+    }
+    const view = this._HEAPU8.subarray(this._dstPtr, this._dstPtr + size);
+    return _utf8.decode(this._shared ? view.slice() : view);
+  }
+
+  /**
+   * Single pass decode into the dst area, returns the decoded size, or -1 when the input
+   * needs streaming (no expected size, or above the single pass thresholds)
+   */
+  private _single(compressedData: Uint8Array, expectedSize?: number): number {
     if (!this._exports) throw new err('not init');
 
     const srcSize = compressedData.length;
@@ -181,20 +403,45 @@ class ZstdDecoder {
 
     if (!expectedSize) expectedSize = _fss(compressedData);
 
-    // No expected size, or above thresholds for single pass => Use streaming
-    if (expectedSize > _MAX_DST_BUF || srcSize > _MAX_SRC_BUF) {
-      return this.decompressStream(compressedData, true).buf;
-    }
+    if (expectedSize > this._dstBuf || srcSize > this._srcBuf) return -1;
 
     const _dstPtr = this._dstPtr;
-    this._exports.pb(_dstPtr);
-    this._HEAPU8.set(compressedData as Uint8Array, this._srcPtr);
-    const result = this._exports.dS(_dstPtr, _MAX_DST_BUF, this._srcPtr, srcSize);
+    // Already in place (inputBuffer)
+    if (compressedData.buffer != this._HEAPU8.buffer || compressedData.byteOffset != this._srcPtr) {
+      this._HEAPU8.set(compressedData as Uint8Array, this._srcPtr);
+    }
+    if (this._fp) this._exports.fp(this._fp);
+    const result = this._exports.dS(_dstPtr, this._dstBuf, this._srcPtr, srcSize);
 
     if (result < 0) {
-      throw new err(`dec err ${result}`);
+      throw this._error(result);
     }
-    return this._HEAPU8.slice(_dstPtr, _dstPtr + result);
+    return result;
+  }
+
+  /**
+   * Splits the src area between the input step and the output buffer from the stream's
+   * decoded / compressed ratio (staged output included), so a step yields about one flush:
+   * short steps & large flushes for highly compressible data, the reverse for incompressible
+   * data. Steps hold at least one full block of the frame (Block_Maximum_Size + header).
+   * Returns true when the step changed by 2x or more.
+   */
+  private _resize(): boolean {
+    const src = this._srcBuf;
+    const staged = this._streamIn ? this._HEAPU32[(this._outStruct >>> 2) + 2] : 0;
+    const ratio = this._streamIn > src >> 3 ? (this._streamOut + staged) / this._streamIn : _PRIOR_RATIO;
+    const block = Math.min(this._bsm + 3, src >> 2);
+    const inChunk = Math.min(Math.max(Math.ceil(src / (1 + ratio)), block), src >> 1);
+    if (this._streamIn && inChunk < this._inChunk * 2 && inChunk * 2 > this._inChunk) return false;
+    this._inChunk = inChunk;
+    this._outCap = src - inChunk;
+    // Room for one more decoded block before the flush
+    this._outFlush = this._outCap - block;
+    return true;
+  }
+
+  private _error(code: number): Error {
+    return new err(code == _WINDOW_TOO_LARGE && this._small ? 'win>1mb lim' : `dec err ${code}`);
   }
 
   /**
@@ -207,89 +454,249 @@ class ZstdDecoder {
     this._HEAPU32[u32Index + 2] = 0;
   }
 
-  /**
-   * Optimized struct read using Uint32Array
-   */
-  private _readStreamPos(ptr: number): number {
-    return this._HEAPU32[(ptr + 8) >>> 2];
-  }
-
   /**
    * Streadming decompression - can be fed chunks incrementally
    *
    * @param input - Input chunk
    * @param reset - Reset stream for new decompression (default: false)
+   * @param emit - Receives every flushed output slice instead of one concatenated buffer,
+   * and the delimiter offsets within it when a record delimiter is set
    * @returns Decompression result with buffer, code, and input offset
    */
-  decompressStream(input: Uint8Array, reset = false): StreamResult {
+  decompressStream(
+    input: Uint8Array,
+    reset = false,
+    emit?: (chunk: Uint8Array, records?: Uint32Array) => void,
+  ): StreamResult {
     if (!this._exports) throw new err('not init');
 
     // Reset stream state for new decompression - ZSTD_reset_session_only = 1
     if (reset) {
       this._exports.re();
-      this._exports.pb(this._dstPtr);
+      if (this._fp) this._exports.fp(this._fp);
+      this._bsm = _bsm(input);
+      this._streamIn = this._streamOut = 0;
     }
     const inLen = input.length || 0;
     if (inLen == 0) return _STREAM_RESULT;
+    // Input in wasm memory (inputBuffer) would be overwritten by the staged output
+    if (input.buffer == this._HEAPU8.buffer) input = input.slice();
 
     const output: Uint8Array[] = [];
-
     let totalOutputSize = 0;
-    let offset = 0;
-    
-    // Assuming 4-8x compressability in the average case
-    // Write to src buf less.
-    // Let 1mb - 128kb out buf accumulate before we flush it out back to js
-    const dstBufStart = this._srcPtr + 262150;
-    let dstOffset = dstBufStart;
-    const dstMaxBuf = dstBufStart + 655360;
-    let lastOut = 0;
-    while (offset < inLen) {
-      //ZSTD_BLOCKSIZE_MAX + ZSTD_BLOCKHEADERSIZE (131072 + 3) x 2 == 262150
-      const toProcess = Math.min(inLen - offset, 262150); 
-      this._HEAPU8.set((input as Uint8Array).subarray(offset, offset + toProcess), this._srcPtr);
-
-      this._writeStreamStruct(_streamInputStructPtr, this._srcPtr, toProcess);
-
-      if (dstOffset == dstBufStart) {
-        this._writeStreamStruct(_streamOutputStructPtr, dstOffset, 917501);
+    const prevSink = _sink;
+    _sink = (ptr, len) => {
+      totalOutputSize += len;
+      if (totalOutputSize > this._maxDstSize) {
+        throw new err(`dec size>maxDstSize lim`);
       }
+      this._streamOut += len;
+      const chunk = this._view && !this._shared
+        ? this._HEAPU8.subarray(ptr, ptr + len)
+        : this._HEAPU8.slice(ptr, ptr + len);
+      if (!emit) output.push(chunk);
+      else if (!this._rd) emit(chunk);
+      else emit(chunk, this._HEAPU32.slice(this._rd + 1, this._rd + 1 + this._HEAPU32[this._rd]));
+    };
 
-      // Process all data in current block
-      while (this._readStreamPos(_streamInputStructPtr) < toProcess) {
-        const result = this._exports.ds();
-        if (result < 0) throw new err(`dec err ${result}`);
-
-        const outputPos = this._readStreamPos(_streamOutputStructPtr);
-
-        totalOutputSize += dstOffset == dstBufStart ? outputPos : outputPos - lastOut;
-        lastOut = outputPos;
-        if (outputPos > 0) {
-          dstOffset = dstBufStart + outputPos;
-
-          if (dstOffset >= dstMaxBuf) {
-            output.push(this._HEAPU8.slice(dstBufStart, dstOffset));
-            dstOffset = dstBufStart;
-            this._writeStreamStruct(_streamOutputStructPtr, dstOffset, 917501);
-          }
-
-          if (totalOutputSize > this._maxDstSize) {
-            throw new err(
-              `dec size>maxDstSize lim`,
-            );
-          }
+    try {
+      // Fixed: assuming 4-8x compressability in the average case, write to src buf less and
+      // let 1mb - 128kb out buf accumulate before dl() flushes it out back to js
+      if (this._adaptive) this._resize();
+      this._writeStreamStruct(this._outStruct, this._srcPtr + this._inChunk, this._outCap);
+      for (let offset = 0; offset < inLen; ) {
+        //ZSTD_BLOCKSIZE_MAX + ZSTD_BLOCKHEADERSIZE (131072 + 3) x 2 == 262150 (64kb in the small build)
+        const toProcess = Math.min(inLen - offset, this._inChunk);
+        this._HEAPU8.set((input as Uint8Array).subarray(offset, offset + toProcess), this._srcPtr);
+        offset += toProcess;
+        const result = this._exports.dl(this._srcPtr, toProcess, this._outFlush, +(offset == inLen));
+        if (result < 0) throw this._error(result);
+        this._streamIn += toProcess;
+        // Re-split the src area once the observed ratio calls for a different step,
+        // the staged output is flushed first (dl() without input)
+        if (this._adaptive && offset < inLen && this._resize()) {
+          this._exports.dl(this._srcPtr, 0, 0, 1);
+          this._writeStreamStruct(this._outStruct, this._srcPtr + this._inChunk, this._outCap);
         }
       }
-      offset += toProcess;
+    } finally {
+      _sink = prevSink;
     }
 
-    // Flush remaining chunk
-    if (dstOffset != dstBufStart) output.push(this._HEAPU8.slice(dstBufStart, dstOffset));
-
-    return {
-      buf: _concatUint8Arrays(output, totalOutputSize),
+    const result: StreamResult = {
+      buf: emit ? _STREAM_RESULT.buf : _concatUint8Arrays(output, totalOutputSize),
       in_offset: inLen,
     };
+    if (this._fp) result.fingerprint = this.fingerprint();
+    return result;
+  }
+
+  /**
+   * XXH3 of the output of the last decompressSync, or of the current decompressStream stream
+   * so far (64 or 128 bit per the fingerprint option)
+   */
+  fingerprint(): bigint {
+    if (!this._exports) throw new err('not init');
+    if (!this._fp) throw new err('fingerprint off');
+    const [low, high] = new BigUint64Array(this._HEAPU8.buffer, this._exports.fd(), 2);
+    return this._fp == 2 ? (high << 64n) | low : low;
+  }
+
+  /**
+   * Snapshot of the current decompressStream stream, to resume it with {@link restore} in
+   * another decoder: another instance, worker or process, of the same wasm build, dictionary &
+   * options. Holds the decoding context (frame & block stage, entropy tables, repeat offsets,
+   * checksum & fingerprint state), the partially loaded block and the live window: about
+   * windowSize + 28 KB. Taken between decompressStream calls, the stream is left untouched.
+   */
+  checkpoint(): Uint8Array {
+    if (!this._exports) throw new err('not init');
+    const i = this._exports.ck() >>> 2;
+    const h = this._HEAPU32;
+    const count = h[i];
+    let size = _CK_HEADER;
+    for (let r = 0; r < count; ++r) size += 8 + h[i + 3 + r * 2];
+
+    const snapshot = new Uint8Array(size);
+    const view = new DataView(snapshot.buffer);
+    const header = [
+      _CK_MAGIC,
+      this._HEAPU8.length,
+      this._dstPtr,
+      this._dictionary ? _h32(this._dictionary, 0) >>> 0 : 0,
+      this._fp,
+      this._bsm,
+      this._inChunk,
+      this._outCap,
+      this._outFlush,
+      h[i + 1],
+      count,
+    ];
+    header.forEach((value, k) => view.setUint32(k * 4, value, true));
+    view.setFloat64(44, this._streamIn, true);
+    view.setFloat64(52, this._streamOut, true);
+    for (let r = 0, off = _CK_HEADER; r < count; ++r) {
+      const ptr = h[i + 2 + r * 2];
+      const len = h[i + 3 + r * 2];
+      view.setUint32(off, ptr, true);
+      view.setUint32(off + 4, len, true);
+      snapshot.set(this._HEAPU8.subarray(ptr, ptr + len), off + 8);
+      off += 8 + len;
+    }
+    return snapshot;
+  }
+
+  /**
+   * Resumes the stream of a {@link checkpoint}: the next decompressStream call (reset false)
+   * continues right where the checkpointed decoder stopped. Replaces the current stream.
+   */
+  restore(snapshot: Uint8Array): void {
+    if (!this._exports) throw new err('not init');
+    const view = new DataView(snapshot.buffer, snapshot.byteOffset, snapshot.byteLength);
+    const u32 = (off: number) => (off + 4 <= snapshot.length ? view.getUint32(off, true) : -1);
+    // Same layout: build (memory, DCtx regions), dictionary (dst area) & fingerprint mode
+    const i = this._exports.ck() >>> 2;
+    const h = this._HEAPU32;
+    let ok =
+      u32(0) == _CK_MAGIC &&
+      u32(4) == this._HEAPU8.length &&
+      u32(8) == this._dstPtr &&
+      u32(12) == (this._dictionary ? _h32(this._dictionary, 0) >>> 0 : 0) &&
+      u32(16) == this._fp &&
+      u32(40) >= 3;
+    const count = u32(40);
+    for (let r = 0, off = _CK_HEADER; ok && r < count; ++r) {
+      const ptr = u32(off);
+      const len = u32(off + 4);
+      // The first regions are the DCtx itself
+      ok = r < 3 ? ptr == h[i + 2 + r * 2] && len == h[i + 3 + r * 2] : ptr + len <= h.length * 4;
+      ok &&= off + 8 + len <= snapshot.length;
+      off += 8 + len;
+    }
+    if (!ok) throw new err('snapshot mismatch');
+
+    for (let r = 0, off = _CK_HEADER; r < count; ++r) {
+      const ptr = u32(off);
+      const len = u32(off + 4);
+      this._HEAPU8.set(snapshot.subarray(off + 8, off + 8 + len), ptr);
+      off += 8 + len;
+    }
+    this._exports.ar(u32(36));
+    this._bsm = u32(20);
+    this._inChunk = u32(24);
+    this._outCap = u32(28);
+    this._outFlush = u32(32);
+    this._streamIn = view.getFloat64(44, true);
+    this._streamOut = view.getFloat64(52, true);
+  }
+
+  /**
+   * decompressStream handing emit views of wasm memory instead of copies, only valid until
+   * emit returns (the staging area is reused by the next flush)
+   */
+  _views(input: Uint8Array, reset: boolean, emit: (chunk: Uint8Array) => void): void {
+    this._view = true;
+    try {
+      this.decompressStream(input, reset, emit);
+    } finally {
+      this._view = false;
+    }
+  }
+
+  /**
+   * decompressStream to text: every flushed slice is UTF-8 decoded from a view of wasm memory,
+   * text keeps the sequences split across slices & calls ({ stream: true })
+   */
+  _text(input: Uint8Array, reset: boolean, text: TextDecoder): string {
+    let out = '';
+    this._views(input, reset, (chunk) => {
+      out += text.decode(chunk, { stream: true });
+    });
+    return out;
+  }
+
+  /**
+   * Whether the decompressStream stream so far stops inside a frame: more input is needed to
+   * finish it (truncated when the input is over)
+   */
+  _midFrame(): boolean {
+    return this._exports.dl(this._srcPtr, 0, 0, 0) > 0;
+  }
+
+  /**
+   * Scans the flushed output of decompressStream for a delimiter byte (e.g. 0x0a) in wasm, with
+   * SIMD: emit then also receives its offsets within each chunk. No argument turns it off.
+   */
+  recordDelimiter(byte?: number): void {
+    if (!this._exports) throw new err('not init');
+    this._rd = byte === undefined ? (this._exports.rd(-1), 0) : this._exports.rd(byte & 255) >>> 2;
+  }
+
+  /**
+   * Entropy table cache counters (always zero in the small window build, which has no cache)
+   */
+  tableCacheStats(): TableCacheStats {
+    if (!this._exports) throw new err('not init');
+    const i = this._exports.tc() >>> 2;
+    const h = this._HEAPU32;
+    return { huffman: { hits: h[i], misses: h[i + 1] }, fse: { hits: h[i + 2], misses: h[i + 3] } };
+  }
+
+  /**
+   * Memory high-water mark since the last call: [region bytes used, of which stream arena bytes]
+   * (stream window & input buffers, single pass output). Restarts the mark.
+   */
+  _highWater(): [number, number] {
+    const peak = this._HEAPU32[(this._exports.hw(1) >>> 2) + 2];
+    return [peak - this._base, peak - this._dstPtr];
+  }
+
+  /**
+   * Linear memory of the instance (fixed, 16 MB or 2 MB for the small window build), or its
+   * region of the host's memory
+   */
+  _memorySize(): number {
+    return this._size;
   }
 
   /**
@@ -303,4 +710,4 @@ class ZstdDecoder {
 
 export default ZstdDecoder;
 export { ZstdDecoder };
-export type { DecoderOptions, StreamResult } from './types.js';
+export type { DecoderMemory, DecoderOptions, StreamResult, TableCacheStats } from './types.js';
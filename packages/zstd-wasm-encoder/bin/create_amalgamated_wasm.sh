@@ -0,0 +1,56 @@
+#!/bin/sh
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ZSTD_SRC_ROOT="$SCRIPT_DIR/../../../vendor/zstd/lib"
+FREESTANDING_SCRIPT="$SCRIPT_DIR/../../../vendor/zstd/contrib/freestanding_lib/freestanding.py"
+COMBINE_SCRIPT="$SCRIPT_DIR/../../../vendor/zstd/build/single_file_libs/combine.py"
+# Minimal libc headers are shared with the decoder
+INCLUDE_DIR="$SCRIPT_DIR/../../zstd-wasm-decoder/bin/include"
+TEMP_LIB="$SCRIPT_DIR/temp_optimized_lib"
+
+cd "$SCRIPT_DIR"
+echo "Preprocessing zstd library with freestanding.py..."
+# Only the fast, dfast & greedy block compressors are kept
+python3 "$FREESTANDING_SCRIPT" \
+  --source-lib "$ZSTD_SRC_ROOT" \
+  --output-lib "$TEMP_LIB" \
+  --zstd-deps "$ZSTD_SRC_ROOT/common/zstd_deps.h" \
+  --mem "$ZSTD_SRC_ROOT/common/mem.h" \
+  -DZSTD_STATIC_LINKING_ONLY \
+  -DMEM_FORCE_MEMORY_ACCESS=2 \
+  -UZSTD_LEGACY_SUPPORT \
+  -UZSTD_MULTITHREAD \
+  -DZSTD_DEPS_NEED_MALLOC \
+  -DZSTD_DEPS_NEED_MATH64 \
+  -DZSTD_EXCLUDE_LAZY_BLOCK_COMPRESSOR \
+  -DZSTD_EXCLUDE_LAZY2_BLOCK_COMPRESSOR \
+  -DZSTD_EXCLUDE_BTLAZY2_BLOCK_COMPRESSOR \
+  -DZSTD_EXCLUDE_BTOPT_BLOCK_COMPRESSOR \
+  -DZSTD_EXCLUDE_BTULTRA_BLOCK_COMPRESSOR
+
+if [ $? -ne 0 ]; then
+  echo "ERROR: freestanding.py failed"
+  rm -rf "$TEMP_LIB"
+  exit 1
+fi
+
+echo "Amalgamating with WASM wrapper..."
+python3 "$COMBINE_SCRIPT" \
+  -r "$TEMP_LIB" \
+  -r "$INCLUDE_DIR" \
+  -x legacy/zstd_legacy.h \
+  -o zstd_wasm_amalgamated.c \
+  zstd_wasm_full.c
+
+if [ $? -ne 0 ]; then
+  echo "ERROR: Amalgamation failed"
+  rm -rf "$TEMP_LIB"
+  exit 1
+fi
+
+rm -rf "$TEMP_LIB"
+
+echo "✓ Successfully created zstd_wasm_amalgamated.c"
+ls -lh zstd_wasm_amalgamated.c
@@ -0,0 +1,222 @@
+/**
+ * \file zstd_wasm_full.c
+ * Fast-levels-only Zstandard WASM encoder with wrapper functions.
+ *
+ * Counterpart of packages/zstd-wasm-decoder/bin/zstd_wasm_full.c, amalgamated by
+ * create_amalgamated_wasm.sh through the same freestanding.py / combine.py pipeline.
+ *
+ * Only the ZSTD_fast, ZSTD_dfast and ZSTD_greedy block compressors are built
+ * (ZSTD_EXCLUDE_*_BLOCK_COMPRESSOR). Levels are capped at ZSTD_WASM_MAX_LEVEL (4),
+ * anything above would cascade down to greedy with tables sized for the higher level.
+ */
+
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+
+/*
+    Layout (fixed memory, no growth):
+
+                             4b srcPtr          4b dstPtr
+                                4b size            4b size
+                                   4b pos             4b pos
+                                      4b pad             4b pad
+    Stack        ZSTD_inBuffer*    ZSTD_outBuffer*      .rodata     CCtx workspace       Src / Dst
+    0 <--- 65536 --->              --->                 --->        __heap_base  (~4.8MB)  (JS malloc)
+                 65536             65552               65568
+
+    The compression context is static (ZSTD_initStaticCCtx): its workspace is reserved once,
+    sized for streaming at ZSTD_WASM_MAX_LEVEL, and never resized. The bump allocator is
+    therefore only used at init, there is nothing to prune.
+
+    Compression needs a deeper stack than the decoder (entropy table building), hence 64kb.
+*/
+
+#ifndef ZSTD_WASM_MAX_LEVEL
+#define ZSTD_WASM_MAX_LEVEL 4
+#endif
+
+/* xxHash configuration */
+#undef  XXH_NAMESPACE
+#define XXH_NAMESPACE ZSTD_
+#undef  XXH_PRIVATE_API
+#define XXH_PRIVATE_API
+#undef  XXH_INLINE_ALL
+#define XXH_INLINE_ALL
+
+#include "stddef.h"
+#include "stdint.h"
+
+#ifdef __wasm__
+#define WASM_EXPORT __attribute__((visibility("default")))
+// Not read only, but keeps the stream structs at the lowest data offsets (see the decoder).
+#define WASM_PINNED __attribute__((section(".rodata")))
+#else
+// Host build of the same amalgamation (native checks). libc provides the allocator.
+#define WASM_EXPORT
+#define WASM_PINNED
+#endif
+#define XXH_FORCE_MEMORY_ACCESS 2
+#include "common/zstd_deps.h"
+
+#include "common/debug.c"
+#include "common/entropy_common.c"
+#include "common/error_private.c"
+#include "common/fse_decompress.c"
+#include "common/zstd_common.c"
+
+#include "compress/fse_compress.c"
+#include "compress/hist.c"
+#include "compress/huf_compress.c"
+#include "compress/zstd_compress_literals.c"
+#include "compress/zstd_compress_sequences.c"
+#include "compress/zstd_compress_superblock.c"
+#include "compress/zstd_preSplit.c"
+#include "compress/zstd_fast.c"
+#include "compress/zstd_double_fast.c"
+#include "compress/zstd_lazy.c"
+#include "compress/zstd_ldm.c"
+#include "compress/zstd_opt.c"
+
+typedef struct {
+    ZSTD_inBuffer in_buffer;
+    unsigned char pad[4];
+    ZSTD_outBuffer out_buffer;
+    unsigned char pad2[4];
+} __attribute__((aligned(32))) ZstdBufsObject;
+
+WASM_PINNED
+static ZstdBufsObject ZstdBufs;
+
+static ZSTD_CCtx* cctx;
+static ZSTD_inBuffer* const in_buffer = (ZSTD_inBuffer*)&ZstdBufs.in_buffer;
+static ZSTD_outBuffer* const out_buffer = (ZSTD_outBuffer*)&ZstdBufs.out_buffer;
+
+// This is not exported in the final binary but prevents from the structs being put after .rodata.
+WASM_EXPORT
+void* getInBufferPtr(void) {
+    return (void*)in_buffer;
+}
+
+#include "compress/zstd_compress.c"
+
+#ifdef __wasm__
+// Heap_cursor as internal mutable global, starts at the linker provided __heap_base
+extern unsigned char __heap_base;
+extern unsigned char __heap_cursor;
+__asm__(
+    ".globaltype __heap_cursor, i32\n"
+    "__heap_cursor:\n"
+);
+
+// Bump only, see the decoder. Nothing is ever freed: the CCtx workspace, src & dst
+// buffers are reserved once per instance.
+WASM_EXPORT
+void* malloc(size_t size) {
+    size_t ptr;
+    __asm__(
+        "local.get %0\n"
+        "global.get __heap_cursor\n"
+        "local.tee %0\n"
+        "i32.add\n"
+        "global.set __heap_cursor\n"
+        : "=r"(ptr)
+        : "r"((size + 7) & ~(size_t)7)
+    );
+    return (void*)ptr;
+}
+
+void free(void* ptr) {
+    (void)ptr; // no-op
+}
+
+void* calloc(size_t nmemb, size_t size) {
+    size_t total = nmemb * size;
+    void* ptr = malloc(total);
+    if (ptr) {
+        __builtin_memset(ptr, 0, total);
+    }
+    return ptr;
+}
+
+void* memcpy(void* dest, const void* src, size_t n) {
+    return __builtin_memcpy(dest, src, n);
+}
+
+void* memset(void* s, int c, size_t n) {
+    return __builtin_memset(s, c, n);
+}
+
+void* memmove(void* dest, const void* src, size_t n) {
+    return __builtin_memmove(dest, src, n);
+}
+
+static void heap_init(void) {
+    size_t const base = ((size_t)&__heap_base + 7) & ~(size_t)7;
+    __asm__(
+        "local.get %0\n"
+        "global.set __heap_cursor\n"
+        :
+        : "r"(base)
+    );
+}
+#else
+#include <stdlib.h>
+static void heap_init(void) {}
+#endif
+
+// Entry point: reserve the static context, sized for streaming at the highest supported level.
+void _initialize(void) {
+    size_t const wkspSize = ZSTD_estimateCStreamSize(ZSTD_WASM_MAX_LEVEL);
+    heap_init();
+    cctx = ZSTD_initStaticCCtx(malloc(wkspSize), wkspSize);
+    // A static CCtx is only zeroed: default parameters (content size flag, level 3)
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_parameters);
+}
+
+/*
+    ZSTD_CCtx_setParameter. Levels are capped, the workspace is only sized up to ZSTD_WASM_MAX_LEVEL.
+*/
+WASM_EXPORT
+size_t sp(int param, int value) {
+    if (param == ZSTD_c_compressionLevel && value > ZSTD_WASM_MAX_LEVEL) value = ZSTD_WASM_MAX_LEVEL;
+    return ZSTD_CCtx_setParameter(cctx, (ZSTD_cParameter)param, value);
+}
+
+/*
+    ZSTD_CCtx_setPledgedSrcSize, so streamed frames still carry their content size
+*/
+WASM_EXPORT
+size_t ps(size_t srcSize) {
+    return ZSTD_CCtx_setPledgedSrcSize(cctx, (unsigned long long)srcSize);
+}
+
+// Reset the session (parameters are kept)
+WASM_EXPORT
+void re(void) {
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+}
+
+/*
+    ZSTD_compress2: single pass, one frame with its content size
+*/
+WASM_EXPORT
+size_t cS(void* dst, size_t dstCapacity, const void* src, size_t srcSize) {
+    return ZSTD_compress2(cctx, dst, dstCapacity, src, srcSize);
+}
+
+/*
+    ZSTD_compressStream2 on the pinned in / out buffers.
+    endOp: 0 continue, 1 flush, 2 end. Returns the amount left to flush (0 when done).
+*/
+WASM_EXPORT
+size_t cs(int endOp) {
+    return ZSTD_compressStream2(cctx, out_buffer, in_buffer, (ZSTD_EndDirective)endOp);
+}
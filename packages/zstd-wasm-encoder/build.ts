@@ -0,0 +1,116 @@
+#!/usr/bin/env bun
+
+/**
+ * Encoder bundles, same pipeline as packages/zstd-wasm-decoder/build.ts (Bun.build + terser + tsc)
+ * minus the inlined variants.
+ */
+
+import { execSync } from 'node:child_process';
+import { copyFileSync, existsSync, mkdirSync, readFileSync, writeFileSync } from 'node:fs';
+import { join } from 'node:path';
+import { minify } from 'terser';
+
+const PKG_DIR = import.meta.dir;
+const SRC_DIR = join(PKG_DIR, 'src');
+const ESM_DIR = join(SRC_DIR, '_esm');
+const TYPES_DIR = join(SRC_DIR, '_types');
+const BUILD_DIR = join(PKG_DIR, 'build');
+const WASM_SOURCE_PATH = join(BUILD_DIR, 'zstd-encoder.wasm');
+const WASM_PERF_PATH = join(BUILD_DIR, 'zstd-encoder-perf.wasm');
+
+[ESM_DIR, TYPES_DIR].forEach((dir) => {
+  if (!existsSync(dir)) mkdirSync(dir, { recursive: true });
+});
+
+for (const path of [WASM_SOURCE_PATH, WASM_PERF_PATH]) {
+  if (!existsSync(path)) {
+    console.error('WASM file not found at:', path);
+    process.exit(1);
+  }
+}
+
+console.log(`WASM size-optimized: ${Bun.file(WASM_SOURCE_PATH).size.toLocaleString()} bytes`);
+console.log(`WASM perf-optimized: ${Bun.file(WASM_PERF_PATH).size.toLocaleString()} bytes\n`);
+
+const terserOptions = {
+  ecma: 2020 as const,
+  module: true,
+  toplevel: true,
+  mangle: {
+    toplevel: true,
+    reserved: ['_initialize'],
+    properties: {
+      regex: /^_(?!initialize)/,
+      reserved: ['_initialize'],
+    },
+  },
+  compress: {
+    drop_console: true,
+    drop_debugger: true,
+    passes: 2,
+    pure_getters: true,
+    unsafe_arrows: true,
+    keep_fargs: false,
+  },
+  format: {
+    ascii_only: true,
+    comments: (_node: unknown, comment: { value: string }) =>
+      /^\s*!?\s*(@__PURE__|@__NO_SIDE_EFFECTS__|#__PURE__|#__NO_SIDE_EFFECTS__)/.test(comment.value),
+    preserve_annotations: true,
+  },
+};
+
+const configs = [
+  { name: 'Web ESM', entry: 'index.web.ts', outfile: 'index.web.js', target: 'browser' },
+  { name: 'Node.js ESM', entry: 'index.node.ts', outfile: 'index.node.js', target: 'node' },
+  { name: 'Core Library', entry: 'zstd-wasm.ts', outfile: 'zstd-wasm.js', target: 'browser' },
+] as const;
+
+for (const config of configs) {
+  const result = await Bun.build({
+    entrypoints: [join(SRC_DIR, config.entry)],
+    outdir: ESM_DIR,
+    target: config.target,
+    format: 'esm',
+    conditions: config.target === 'browser' ? ['browser', 'import'] : ['node', 'import'],
+    naming: config.outfile,
+    sourcemap: 'linked',
+    packages: 'external',
+    emitDCEAnnotations: true,
+    drop: ['console', 'debugger'],
+  });
+
+  if (!result.success) {
+    console.error(`Failed to build ${config.name}`);
+    for (const log of result.logs) console.error(log);
+    process.exit(1);
+  }
+
+  const filePath = join(ESM_DIR, config.outfile);
+  const minified = await minify(readFileSync(filePath, 'utf8'), terserOptions);
+  if (minified.code) writeFileSync(filePath, minified.code);
+  console.log(`Built (minified): ${config.outfile}`);
+}
+
+const webJs = readFileSync(join(ESM_DIR, 'index.web.js'), 'utf8');
+writeFileSync(
+  join(ESM_DIR, 'index.web.perf.js'),
+  webJs.replace(/zstd-encoder\.wasm/g, 'zstd-encoder-perf.wasm'),
+);
+console.log('Built: index.web.perf.js (via string replacement)');
+
+copyFileSync(WASM_SOURCE_PATH, join(ESM_DIR, 'zstd-encoder.wasm'));
+copyFileSync(WASM_PERF_PATH, join(ESM_DIR, 'zstd-encoder-perf.wasm'));
+
+try {
+  execSync('tsc --project tsconfig.json', {
+    cwd: PKG_DIR,
+    stdio: 'inherit',
+    env: { ...process.env, FORCE_COLOR: '1' },
+  });
+  copyFileSync(join(SRC_DIR, 'types.d.ts'), join(TYPES_DIR, 'types.d.ts'));
+  console.log('Copied: types.d.ts');
+} catch (error) {
+  console.error(error);
+  process.exit(1);
+}
@@ -0,0 +1,18 @@
+import { readFileSync } from 'node:fs';
+import { _internal } from './shared.js';
+
+// biome-ignore lint/performance/noBarrelFile: entrypoint module
+export {
+  compress,
+  compressSync,
+  createEncoder,
+  ZstdCompressionStream,
+  ZstdEncoder,
+} from './shared.js';
+
+export type { EncoderOptions, ZstdCompressOptions } from './types.js';
+
+_internal._loader = (wasmPath?: string) =>
+  new WebAssembly.Module(
+    readFileSync(wasmPath || new URL('./zstd-encoder-perf.wasm', import.meta.url)),
+  );
@@ -0,0 +1,17 @@
+import { _internal } from './shared.js';
+
+// biome-ignore lint/performance/noBarrelFile: entrypoint module
+export {
+  compress,
+  compressSync,
+  createEncoder,
+  ZstdCompressionStream,
+  ZstdEncoder,
+} from './shared.js';
+
+export type { EncoderOptions, ZstdCompressOptions } from './types.js';
+
+_internal._loader = async (wasmPath?: string) => {
+  const response = await fetch(wasmPath || new URL('./zstd-encoder.wasm', import.meta.url).href);
+  return await WebAssembly.compileStreaming(response);
+};
@@ -0,0 +1,159 @@
+import ZstdEncoder from './zstd-wasm.js';
+export { default as ZstdEncoder, _MAX_LEVEL } from './zstd-wasm.js';
+
+import type { EncoderOptions, ZstdCompressOptions } from './types.js';
+
+export const _internal = {
+  _loader: null as ((wasmPath?: string) => WebAssembly.Module | Promise<WebAssembly.Module>) | null,
+};
+
+let cachedModule: WebAssembly.Module;
+
+// Encoders are level agnostic (setLevel per frame), a single pool is enough
+const pool: ZstdEncoder[] = [];
+const locks: boolean[] = [];
+
+const _loadModule = async (wasmPath?: string) => {
+  if (!cachedModule) {
+    const module = _internal._loader!(wasmPath);
+    cachedModule = module instanceof Promise ? await module : module;
+  }
+  return cachedModule;
+};
+
+function _acquireEncoderSync(options?: EncoderOptions): [ZstdEncoder, number] {
+  // Checksums are fixed at init, those encoders are never pooled
+  if (!options?.checksum) {
+    for (let i = 0; i < locks.length; ++i) {
+      if (!locks[i]) {
+        locks[i] = true;
+        pool[i].setLevel(options?.level ?? 3);
+        return [pool[i], i];
+      }
+    }
+  }
+
+  const encoder = new ZstdEncoder(options).init(cachedModule);
+  if (options?.checksum || locks.length > 2) return [encoder, -1];
+
+  pool.push(encoder);
+  locks.push(true);
+  return [encoder, locks.length - 1];
+}
+
+export async function _acquireEncoder(
+  options?: ZstdCompressOptions,
+): Promise<[ZstdEncoder, number]> {
+  await _loadModule(options?.wasmPath);
+  return _acquireEncoderSync(options);
+}
+
+export function _releaseEncoder(encoder: ZstdEncoder, idx: number): void {
+  idx == -1 ? encoder._destroy() : (locks[idx] = false);
+}
+
+const _compressWith = ([encoder, idx]: [ZstdEncoder, number], input: Uint8Array) => {
+  try {
+    return encoder.compressSync(input);
+  } finally {
+    _releaseEncoder(encoder, idx);
+  }
+};
+
+/**
+ * Creates a standalone encoder instance (not pooled)
+ */
+export const createEncoder = /*! @__PURE__ */ async (
+  options?: ZstdCompressOptions,
+): Promise<ZstdEncoder> => new ZstdEncoder(options).init(await _loadModule(options?.wasmPath));
+
+/**
+ * Compress a buffer into a single zstd frame
+ */
+export const compress = /*! @__PURE__ */ async (
+  input: Uint8Array,
+  options?: ZstdCompressOptions,
+): Promise<Uint8Array> => _compressWith(await _acquireEncoder(options), input);
+
+/**
+ * Synchronous compress. Needs the module to be loaded already: always the case in Node,
+ * elsewhere after any compress / createEncoder / ZstdCompressionStream.
+ */
+export const compressSync = /*! @__PURE__ */ (
+  input: Uint8Array,
+  options?: EncoderOptions,
+): Uint8Array => {
+  if (!cachedModule) {
+    const module = _internal._loader!();
+    if (module instanceof Promise) throw new Error('not init');
+    cachedModule = module;
+  }
+  return _compressWith(_acquireEncoderSync(options), input);
+};
+
+/**
+ * Web Streams API transform for Zstandard compression, a `CompressionStream` ponyfill.
+ * Writes one frame, ended when the writable side is closed.
+ *
+ * ```js
+ * const body = file.stream().pipeThrough(new ZstdCompressionStream({ level: 3 }));
+ * await fetch('/upload', { method: 'POST', body, duplex: 'half', headers: { 'Content-Encoding': 'zstd' } });
+ * ```
+ */
+export class ZstdCompressionStream {
+  /**
+   * The resulting compressed stream to read output from.
+   * @type {ReadableStream<Uint8Array>}
+   */
+  readonly readable: ReadableStream<Uint8Array>;
+  /**
+   * The writable end of the stream to pipe uncompressed chunks into.
+   * @type {WritableStream<BufferSource>}
+   */
+  readonly writable: WritableStream<BufferSource>;
+
+  /**
+   * @param {ZstdCompressOptions} [options] - Optional encoder configuration.
+   */
+  constructor(options?: ZstdCompressOptions) {
+    let encoder: ZstdEncoder | undefined;
+    let idx = -1;
+
+    const { readable, writable } = new TransformStream<BufferSource, Uint8Array>({
+      async transform(chunk, controller) {
+        if (!encoder) {
+          [encoder, idx] = await _acquireEncoder(options);
+          encoder.reset();
+        }
+        try {
+          encoder.compressStream(_toUint8Array(chunk), false, (out) => controller.enqueue(out));
+        } catch (er) {
+          _releaseEncoder(encoder, idx);
+          throw er;
+        }
+      },
+      async flush(controller) {
+        if (!encoder) {
+          [encoder, idx] = await _acquireEncoder(options);
+          encoder.reset();
+        }
+        try {
+          encoder.compressStream(_EMPTY, true, (out) => controller.enqueue(out));
+        } finally {
+          _releaseEncoder(encoder, idx);
+        }
+      },
+    });
+    this.readable = readable;
+    this.writable = writable;
+  }
+}
+
+const _EMPTY = new Uint8Array(0);
+
+const _toUint8Array = (chunk: BufferSource): Uint8Array =>
+  chunk instanceof Uint8Array
+    ? chunk
+    : ArrayBuffer.isView(chunk)
+      ? new Uint8Array(chunk.buffer, chunk.byteOffset, chunk.byteLength)
+      : new Uint8Array(chunk);
@@ -0,0 +1,47 @@
+/**
+ * Encoder exported functions.
+ */
+export interface EncoderWasmExports {
+  /** WebAssembly linear memory */
+  memory: WebAssembly.Memory;
+
+  /** Allocate memory in the WASM module */
+  malloc(size: number): number;
+
+  /** Reserves the static ZSTD compression context */
+  _initialize(): void;
+
+  /** Sets a compression parameter (ZSTD_cParameter) */
+  sp(param: number, value: number): number;
+
+  /** Pledges the source size of the next streamed frame */
+  ps(srcSize: number): number;
+
+  /** Resets the compression session, parameters are kept */
+  re(): void;
+
+  /** Compresses data in a single pass */
+  cS(dstPtr: number, dstCapacity: number, srcPtr: number, srcSize: number): number;
+
+  /** Compresses a stream of data (0 continue, 1 flush, 2 end) */
+  cs(endOp: number): number;
+}
+
+/**
+ * Configuration options for the ZSTD encoder.
+ */
+export interface EncoderOptions {
+  /** Compression level, 1 to 4 (default 3). Higher levels are capped to 4, negative levels are faster */
+  level?: number;
+
+  /** Append a content checksum to every frame (default false) */
+  checksum?: boolean;
+}
+
+/**
+ * Options for encoder functions and streams.
+ */
+export interface ZstdCompressOptions extends EncoderOptions {
+  /** Path to the WASM module */
+  wasmPath?: string;
+}
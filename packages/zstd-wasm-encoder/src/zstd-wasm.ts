@@ -0,0 +1,223 @@
+import type { EncoderOptions, EncoderWasmExports } from './types.js';
+
+/**
+ * ╔══════════════════════════════════════════════════════════════╗
+ * ║                        Memory Layout                         ║
+ * ╠══════════════════════════════════════════════════════════════╣
+ * ║   0x00000  ┌────────────────────────────────────┐            ║
+ * ║            │      Stack Space (64 KB)           │            ║
+ * ║   0x10000  ├────────────────────────────────────┤            ║
+ * ║            │  Stream Structs (32 bytes):        │            ║
+ * ║            │    ZSTD_inBuffer  (16b)            │            ║
+ * ║            │    ZSTD_outBuffer (16b)            │            ║
+ * ║   0x10020  ├────────────────────────────────────┤            ║
+ * ║            │   Read-only constants              │            ║
+ * ║ heap_base  ├────────────────────────────────────┤            ║
+ * ║            │   Static ZSTD_CCtx workspace       │            ║
+ * ║            │   ZSTD_estimateCStreamSize(4)      │            ║
+ * ║            │   (~4.75 MB: window, hash / chain  │            ║
+ * ║            │    tables, seqStore, in buffer)    │            ║
+ * ║            ├────────────────────────────────────┤            ║
+ * ║            │    Source Buffer (2 MB)            │            ║
+ * ║            ├────────────────────────────────────┤            ║
+ * ║            │    Destination Buffer              │            ║
+ * ║            │    ZSTD_compressBound(2 MB)        │            ║
+ * ║   ~9.3MB   └────────────────────────────────────┘            ║
+ * ║                                                              ║
+ * ║ Total: 10 MB, fixed (no memory growth)                       ║
+ * ╠══════════════════════════════════════════════════════════════╣
+ * ║ • Inputs up to 2 MB are compressed in a single pass, larger  ║
+ * ║   ones are streamed through the same buffers, with their     ║
+ * ║   size pledged so the frame still carries its content size  ║
+ * ║                                                              ║
+ * ║ • Only the fast, dfast & greedy strategies are compiled in,  ║
+ * ║   levels above 4 are capped                                  ║
+ * ╚══════════════════════════════════════════════════════════════╝
+ */
+
+export const _MAX_SRC_BUF = 2 * 1024 * 1024; // 2 MB input buffer
+// ZSTD_compressBound(_MAX_SRC_BUF)
+export const _MAX_DST_BUF = _MAX_SRC_BUF + (_MAX_SRC_BUF >>> 8);
+export const _MAX_LEVEL = 4;
+const _EMPTY = new Uint8Array(0);
+const _streamInputStructPtr = 65536;
+const _streamOutputStructPtr = 65552;
+
+// ZSTD_cParameter
+const ZSTD_c_compressionLevel = 100;
+const ZSTD_c_checksumFlag = 201;
+// ZSTD_EndDirective
+const ZSTD_e_continue = 0;
+const ZSTD_e_end = 2;
+
+const err = Error;
+
+// Concatenate Uint8Arrays (as in the decoder's utils)
+const _concat = (arrays: Uint8Array[], totalLength: number): Uint8Array => {
+  if (arrays.length == 1) return arrays[0];
+  const result = new Uint8Array(totalLength);
+  let offset = 0;
+  for (const arr of arrays) {
+    result.set(arr, offset);
+    offset += arr.length;
+  }
+  return result;
+};
+
+class ZstdEncoder {
+  private _exports!: EncoderWasmExports;
+  private _HEAPU8!: Uint8Array;
+  private _HEAPU32!: Uint32Array;
+
+  private readonly _level: number;
+  private readonly _checksum: boolean;
+
+  private _srcPtr: number = 0;
+  private _dstPtr: number = 0;
+
+  constructor(options: EncoderOptions = {}) {
+    this._level = Math.min(options.level ?? 3, _MAX_LEVEL);
+    this._checksum = !!options.checksum;
+  }
+
+  /**
+   * Initialize with a compiled WebAssembly module
+   */
+  init(wasmModule: WebAssembly.Module): ZstdEncoder {
+    return this._initCommon(new WebAssembly.Instance(wasmModule, { env: {} }));
+  }
+
+  private _initCommon(wasmInstance: WebAssembly.Instance): ZstdEncoder {
+    this._exports = wasmInstance.exports as unknown as EncoderWasmExports;
+    const _memory = this._exports.memory as WebAssembly.Memory;
+
+    this._HEAPU8 = new Uint8Array(_memory.buffer);
+    this._HEAPU32 = new Uint32Array(_memory.buffer);
+
+    this._exports._initialize();
+    this.setLevel(this._level);
+    this._check(this._exports.sp(ZSTD_c_checksumFlag, +this._checksum));
+
+    this._srcPtr = this._exports.malloc(_MAX_SRC_BUF);
+    this._dstPtr = this._exports.malloc(_MAX_DST_BUF);
+    return this;
+  }
+
+  private _check(result: number): number {
+    if (result < 0) throw new err(`enc err ${result}`);
+    return result;
+  }
+
+  /**
+   * Compression level of the next frame, capped to 4
+   */
+  setLevel(level: number): void {
+    if (!this._exports) throw new err('not init');
+    this._check(this._exports.sp(ZSTD_c_compressionLevel, Math.min(level, _MAX_LEVEL)));
+  }
+
+  /**
+   * Compress a buffer into a single frame.
+   * Single pass up to 2 MB, streamed through the same buffers above.
+   *
+   * @param data - Uncompressed data
+   * @returns Compressed frame
+   */
+  compressSync(data: Uint8Array): Uint8Array {
+    if (!this._exports) throw new err('not init');
+
+    const srcSize = data.length;
+    this._exports.re();
+
+    if (srcSize > _MAX_SRC_BUF) {
+      this._check(this._exports.ps(srcSize));
+      return this.compressStream(data, true);
+    }
+
+    this._HEAPU8.set(data, this._srcPtr);
+    const result = this._check(
+      this._exports.cS(this._dstPtr, _MAX_DST_BUF, this._srcPtr, srcSize),
+    );
+    return this._HEAPU8.slice(this._dstPtr, this._dstPtr + result);
+  }
+
+  private _writeStreamStruct(ptr: number, bufPtr: number, size: number): void {
+    const u32Index = ptr >>> 2;
+    this._HEAPU32[u32Index] = bufPtr;
+    this._HEAPU32[u32Index + 1] = size;
+    this._HEAPU32[u32Index + 2] = 0;
+  }
+
+  private _readStreamPos(ptr: number): number {
+    return this._HEAPU32[(ptr + 8) >>> 2];
+  }
+
+  /**
+   * Streaming compression - can be fed chunks incrementally.
+   * A new frame starts with the first chunk after the previous one was ended.
+   *
+   * @param input - Input chunk
+   * @param end - Finish the frame with this chunk (default: false)
+   * @param emit - Receives every compressed slice instead of one concatenated buffer
+   * @returns Compressed output produced for this chunk (empty with emit)
+   */
+  compressStream(
+    input: Uint8Array,
+    end = false,
+    emit?: (chunk: Uint8Array) => void,
+  ): Uint8Array {
+    if (!this._exports) throw new err('not init');
+
+    const inLen = input.length || 0;
+    const output: Uint8Array[] = [];
+    let totalOutputSize = 0;
+    let offset = 0;
+
+    do {
+      const toProcess = Math.min(inLen - offset, _MAX_SRC_BUF);
+      const last = offset + toProcess == inLen;
+      const endOp = end && last ? ZSTD_e_end : ZSTD_e_continue;
+      if (toProcess) this._HEAPU8.set(input.subarray(offset, offset + toProcess), this._srcPtr);
+      this._writeStreamStruct(_streamInputStructPtr, this._srcPtr, toProcess);
+
+      // Drain until the chunk is consumed, and for the end directive, fully flushed
+      let remaining: number;
+      do {
+        this._writeStreamStruct(_streamOutputStructPtr, this._dstPtr, _MAX_DST_BUF);
+        remaining = this._check(this._exports.cs(endOp));
+        const outputPos = this._readStreamPos(_streamOutputStructPtr);
+        if (outputPos > 0) {
+          const chunk = this._HEAPU8.slice(this._dstPtr, this._dstPtr + outputPos);
+          emit ? emit(chunk) : output.push(chunk);
+          totalOutputSize += outputPos;
+        }
+      } while (
+        this._readStreamPos(_streamInputStructPtr) < toProcess ||
+        (endOp == ZSTD_e_end && remaining)
+      );
+      offset += toProcess;
+    } while (offset < inLen);
+
+    return emit || !totalOutputSize ? _EMPTY : _concat(output, totalOutputSize);
+  }
+
+  /**
+   * Abandon the current frame, the next chunk starts a new one
+   */
+  reset(): void {
+    if (!this._exports) throw new err('not init');
+    this._exports.re();
+  }
+
+  /**
+   * Clean up ZSTD context
+   */
+  _destroy(): void {
+    //@ts-expect-error gc.
+    this._exports = this._HEAPU8 = this._HEAPU32 = null;
+  }
+}
+
+export default ZstdEncoder;
+export { ZstdEncoder };
+export type { EncoderOptions } from './types.js';
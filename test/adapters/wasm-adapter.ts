@@ -13,11 +13,35 @@ const variantMap: Record<string, string> = {
 };
 
 const buildFile = variantMap[TEST_VARIANT] || 'index.node.js';
-const { createDecoder, decompressSync, ZstdDecompressionStream } = await import(
-  `../../packages/zstd-wasm-decoder/src/_esm/${buildFile}`
-);
+const {
+  createDecoder,
+  decodeRecords,
+  decodeZstdResponse,
+  decompressSync,
+  decompressToString,
+  getHybridMetrics,
+  getResultCacheStats,
+  setupHybridDecoder,
+  setupResultCache,
+  setupZstdDecoder,
+  TarZstReader,
+  ZstdDecompressionStream,
+} = await import(`../../packages/zstd-wasm-decoder/src/_esm/${buildFile}`);
 
-export { ZstdDecompressionStream };
+// Hybrid dispatch is only exported by the node entry
+export {
+  decodeRecords,
+  decodeZstdResponse,
+  decompressSync,
+  decompressToString,
+  getHybridMetrics,
+  getResultCacheStats,
+  setupHybridDecoder,
+  setupResultCache,
+  setupZstdDecoder,
+  TarZstReader,
+  ZstdDecompressionStream,
+};
 
 export interface WasmDecoderAdapter {
   decompress(data: Buffer | Uint8Array, options?: ZstdOptions): Promise<Buffer>;
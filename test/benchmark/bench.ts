@@ -4,8 +4,12 @@ import * as zlib from 'node:zlib';
 import {
   decompress as wasmDecompress,
   decompressStream as wasmDecompressStream,
+  decompressSync as wasmDecompressSync,
+  getHybridMetrics,
+  setupHybridDecoder,
   ZstdDecompressionStream,
 } from '../../packages/zstd-wasm-decoder/src/_esm/index.node.js';
+import * as zlibShim from '../../packages/zstd-wasm-decoder/src/_esm/index.zlib.js';
 import { loadCompressedFiles } from './util.js';
 
 const dir = join(import.meta.dirname || process.cwd(), 'compressed');
@@ -49,6 +53,10 @@ const warmup = async (buffers: Buffer[]) => {
         await Bun.zstdDecompress(buf);
       }
       await wasmDecompress(buf);
+      zlibShim.zstdDecompressSync(buf);
+      await new Promise((resolve, reject) =>
+        zlibShim.zstdDecompress(buf, (err, result) => (err ? reject(err) : resolve(result))),
+      );
       await wasmDecompressStream(buf, true);
       await decompressWithStream(buf);
     }
@@ -153,6 +161,50 @@ results.push(
   ),
 );
 
+// Same call shapes as the zlib rows above, zstd-wasm-decoder/zlib
+results.push(
+  await runBenchmark(
+    'zstd-wasm zlib shim (sync)',
+    (buf) => zlibShim.zstdDecompressSync(buf),
+    benchBuffers,
+    metadata.fileSizes,
+  ),
+);
+results.push(
+  await runBenchmark(
+    'zstd-wasm zlib shim (async)',
+    (buf) =>
+      new Promise((resolve, reject) =>
+        zlibShim.zstdDecompress(buf, (err, result) => (err ? reject(err) : resolve(result))),
+      ),
+    benchBuffers,
+    metadata.fileSizes,
+  ),
+);
+
+// Hybrid dispatch: calibrated on the warmup split, then routed per size class
+const calibration = await setupHybridDecoder({
+  samples: loadCompressedFiles(dir)
+    .filter((_, idx) => idx >= metadata.fileCount)
+    .slice(0, 64),
+});
+results.push(
+  await runBenchmark(
+    'zstd-wasm hybrid (sync)',
+    (buf) => wasmDecompressSync(buf),
+    benchBuffers,
+    metadata.fileSizes,
+  ),
+);
+results.push(
+  await runBenchmark(
+    'zstd-wasm hybrid (async)',
+    (buf) => wasmDecompress(buf),
+    benchBuffers,
+    metadata.fileSizes,
+  ),
+);
+
 // Output results
 console.log(`${'='.repeat(50)}`);
 console.log(`Runtime: ${runtime}`);
@@ -160,6 +212,12 @@ console.log(`${'='.repeat(50)}`);
 for (const { name, mbps } of results) {
   console.log(`${name.padEnd(30)} ${mbps.toFixed(2).padStart(10)} MB/s`);
 }
+if (calibration) {
+  const { sync, async, fallbacks } = getHybridMetrics();
+  const routed = (counts: number[][]) => counts.map(([w, n]) => `${w}/${n}`).join(' ');
+  console.log(`\nHybrid routes (${calibration.provider}): sync ${calibration.sync}, async ${calibration.async}`);
+  console.log(`  wasm/native per size class: sync ${routed(sync)} | async ${routed(async)}, ${fallbacks} fallbacks`);
+}
 
 console.log('\n');
 await import('./roundtrip.js');
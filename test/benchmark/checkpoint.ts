@@ -0,0 +1,80 @@
+import { readFileSync } from 'node:fs';
+import { join } from 'node:path';
+import * as zlib from 'node:zlib';
+import { ZstdDecoder } from '../../packages/zstd-wasm-decoder/src/_esm/index.node.js';
+
+/**
+ * Stream checkpoint / restore: snapshot size, and the time to take it and to resume the stream
+ * in another instance, per window size (windowLog 17: 128 KB, 20: 1 MB, 23: 8 MB).
+ *
+ * Each input is a streamed frame (no content size) of test/data/test.json and log lines,
+ * decoded in 64 KB calls; a checkpoint is taken after every call once the window is full and
+ * restored into a second decoder, which decodes the rest: its output is checked against the
+ * source. Reports the median / max snapshot size and the median checkpoint & restore times.
+ */
+
+const dir = import.meta.dirname || process.cwd();
+const wasmPath = join(dir, '../../packages/zstd-wasm-decoder/src/_esm/zstd-decoder-perf.wasm');
+const targetMB = Number(process.env.BENCH_CHECKPOINT_MB) || 32;
+const CALL = 64 * 1024;
+
+const json = readFileSync(join(dir, '../data/test.json'));
+const lines: string[] = [];
+for (let i = 0; lines.length < 20000; ++i) {
+  lines.push(`2025-01-01T00:00:${String(i % 60).padStart(2, '0')}Z INFO request id=${i % 97} latency_ms=${i % 13}`);
+}
+const logs = new TextEncoder().encode(lines.join('\n'));
+const source = new Uint8Array(targetMB * 1024 * 1024);
+for (let i = 0, k = 0; i < source.length; ++k) {
+  const part = k & 1 ? logs : json;
+  source.set(part.subarray(0, source.length - i), i);
+  i += part.length;
+}
+
+const module = new WebAssembly.Module(readFileSync(wasmPath));
+const median = (values: number[]) => [...values].sort((a, b) => a - b)[values.length >> 1];
+
+console.log(`${targetMB} MB per window size, ${CALL / 1024} KB calls\n`);
+console.log(
+  `  ${'window'.padEnd(8)} ${'snapshots'.padStart(10)} ${'median KB'.padStart(10)} ${'max KB'.padStart(8)} ${'checkpoint ms'.padStart(14)} ${'restore ms'.padStart(11)}`,
+);
+for (const windowLog of [17, 20, 23]) {
+  const c = zlib.zstdCompressSync(source, {
+    params: { [zlib.constants.ZSTD_c_contentSizeFlag]: 0, [zlib.constants.ZSTD_c_windowLog]: windowLog },
+  });
+  const frame = new Uint8Array(c.buffer, c.byteOffset, c.byteLength);
+  const decoder = new ZstdDecoder().init(module);
+  const other = new ZstdDecoder().init(module);
+
+  const sizes: number[] = [];
+  const taken: number[] = [];
+  const restored: number[] = [];
+  let decoded = 0;
+  for (let i = 0; i < frame.length; i += CALL) {
+    decoded += decoder.decompressStream(frame.subarray(i, i + CALL), i == 0).buf.length;
+    if (decoded < 1 << windowLog) continue;
+    let start = performance.now();
+    const snapshot = decoder.checkpoint();
+    taken.push(performance.now() - start);
+    start = performance.now();
+    other.restore(snapshot);
+    restored.push(performance.now() - start);
+    sizes.push(snapshot.length);
+  }
+
+  // Resume halfway through in the other decoder, the output has to match
+  let offset = 0;
+  let half = 0;
+  for (; half < frame.length >> 1; half += CALL) {
+    offset += decoder.decompressStream(frame.subarray(half, half + CALL), half == 0).buf.length;
+  }
+  other.restore(decoder.checkpoint());
+  const rest = other.decompressStream(frame.subarray(half), false).buf;
+  if (Buffer.compare(rest, source.subarray(offset)) != 0) {
+    throw new Error(`windowLog ${windowLog}: resumed output differs`);
+  }
+
+  console.log(
+    `  ${`${(1 << windowLog) / 1024} KB`.padEnd(8)} ${String(sizes.length).padStart(10)} ${(median(sizes) / 1024).toFixed(0).padStart(10)} ${(Math.max(...sizes) / 1024).toFixed(0).padStart(8)} ${median(taken).toFixed(3).padStart(14)} ${median(restored).toFixed(3).padStart(11)}`,
+  );
+}
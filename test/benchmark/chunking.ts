@@ -0,0 +1,114 @@
+import { existsSync, readdirSync, readFileSync } from 'node:fs';
+import { join } from 'node:path';
+import * as zlib from 'node:zlib';
+import { ZstdDecoder } from '../../packages/zstd-wasm-decoder/src/_esm/index.node.js';
+
+/**
+ * decompressStream input step / output flush sizing: 'fixed' (256 KB steps, 640 KB flushes)
+ * vs 'adaptive' (split per stream from the observed ratio and the frame's block size).
+ *
+ * Corpus classes, each compressed as streamed frames (no content size, as from a pipe):
+ *   random  incompressible, ~1x
+ *   json    test/data/test.json repeated
+ *   logs    templated log lines, ~100x
+ *   tiny    small frames (< 4 KB decoded), one decompressStream call each
+ *   corpus  the benchmark corpus, when set up (`pnpm run bench:setup`)
+ * Each input is decoded in one call and in 64 KB calls. Reports MB/s of decoded output and
+ * the number of output slices (flushes) handed back to JS.
+ */
+
+const dir = import.meta.dirname || process.cwd();
+const corpusDir = join(dir, 'compressed');
+const wasmPath = join(dir, '../../packages/zstd-wasm-decoder/src/_esm/zstd-decoder-perf.wasm');
+const rounds = Number(process.env.BENCH_ROUNDS) || 5;
+const targetMB = Number(process.env.BENCH_CHUNKING_MB) || 32;
+const CALL = 64 * 1024;
+
+const streamed = (data: Uint8Array): Uint8Array => {
+  const c = zlib.zstdCompressSync(data, {
+    params: { [zlib.constants.ZSTD_c_contentSizeFlag]: 0, [zlib.constants.ZSTD_c_windowLog]: 23 },
+  });
+  return new Uint8Array(c.buffer, c.byteOffset, c.byteLength);
+};
+
+const repeat = (source: Uint8Array): Uint8Array => {
+  const out = new Uint8Array(targetMB * 1024 * 1024);
+  for (let i = 0; i < out.length; i += source.length) out.set(source.subarray(0, out.length - i), i);
+  return out;
+};
+
+const logs = (): Uint8Array => {
+  const lines: string[] = [];
+  for (let i = 0; lines.length < 20000; ++i) {
+    lines.push(
+      `2025-01-01T00:${String((i >> 6) % 60).padStart(2, '0')}:${String(i % 60).padStart(2, '0')}Z INFO request id=${i % 97} status=200 path=/api/v1/items latency_ms=${i % 13}`,
+    );
+  }
+  return new TextEncoder().encode(lines.join('\n'));
+};
+
+const logText = logs();
+const random = new Uint8Array(targetMB * 1024 * 1024);
+for (let i = 0; i < random.length; i += 65536) crypto.getRandomValues(random.subarray(i, i + 65536));
+
+const classes: Array<[string, Uint8Array[]]> = [
+  ['random', [streamed(random)]],
+  ['json', [streamed(repeat(readFileSync(join(dir, '../data/test.json'))))]],
+  ['logs', [streamed(repeat(logText))]],
+  ['tiny', Array.from({ length: 2000 }, (_, i) => streamed(logText.subarray(i, i + 256 + (i % 3840))))],
+];
+if (existsSync(corpusDir)) {
+  classes.push([
+    'corpus',
+    readdirSync(corpusDir)
+      .filter((f) => f.endsWith('.zst'))
+      .map((f) => streamed(zlib.zstdDecompressSync(readFileSync(join(corpusDir, f))))),
+  ]);
+}
+
+const module = new WebAssembly.Module(readFileSync(wasmPath));
+const decoders = {
+  fixed: new ZstdDecoder({ maxSrcSize: 0, maxDstSize: 0, streamSizing: 'fixed' }).init(module),
+  adaptive: new ZstdDecoder({ maxSrcSize: 0, maxDstSize: 0, streamSizing: 'adaptive' }).init(module),
+};
+
+const bench = (decoder: ZstdDecoder, inputs: Uint8Array[], step: number) => {
+  let bytes = 0;
+  let slices = 0;
+  const emit = (chunk: Uint8Array) => {
+    bytes += chunk.length;
+    ++slices;
+  };
+  const decode = () => {
+    for (const input of inputs) {
+      for (let i = 0; i < input.length; i += step) decoder.decompressStream(input.subarray(i, i + step), i == 0, emit);
+    }
+  };
+  decode();
+  const total = bytes;
+  const perRound = slices;
+  let best = 0;
+  for (let r = 0; r < rounds; ++r) {
+    const start = performance.now();
+    decode();
+    best = Math.max(best, total / 1024 / 1024 / ((performance.now() - start) / 1000));
+  }
+  return { mbps: best, slices: perRound };
+};
+
+console.log(`${rounds} rounds, ${targetMB} MB per class\n`);
+console.log(
+  `  ${'class'.padEnd(8)} ${'calls'.padEnd(8)} ${'fixed MB/s'.padStart(11)} ${'slices'.padStart(7)} ${'adaptive MB/s'.padStart(14)} ${'slices'.padStart(7)} ${'speedup'.padStart(8)}`,
+);
+for (const [name, inputs] of classes) {
+  for (const [label, step] of [
+    ['one', Number.MAX_SAFE_INTEGER],
+    ['64 KB', CALL],
+  ] as const) {
+    const fixed = bench(decoders.fixed, inputs, step);
+    const adaptive = bench(decoders.adaptive, inputs, step);
+    console.log(
+      `  ${name.padEnd(8)} ${label.padEnd(8)} ${fixed.mbps.toFixed(1).padStart(11)} ${String(fixed.slices).padStart(7)} ${adaptive.mbps.toFixed(1).padStart(14)} ${String(adaptive.slices).padStart(7)} ${(adaptive.mbps / fixed.mbps).toFixed(2).padStart(7)}x`,
+    );
+  }
+}
@@ -0,0 +1,97 @@
+import { existsSync, readdirSync, readFileSync } from 'node:fs';
+import { join } from 'node:path';
+import * as zlib from 'node:zlib';
+
+/**
+ * Cloudflare Workers: requests/sec of the isolate wide decoder pool vs a fresh instance per request.
+ *
+ * Runs the built _esm/index.cloudflare.js in a local Miniflare isolate (`pnpm add -D miniflare`).
+ * Each request POSTs a compressed payload from the benchmark corpus (or test/data), the worker
+ * decodes it and returns the decompressed body:
+ *   pool   decompressResponse(), leases a pooled decoder for the lifetime of the response
+ *   fresh  createDecoder() + decompressSync(), a new wasm instance per request
+ * Concurrency levels: BENCH_CF_CONCURRENCY (default 1,4,16,64), BENCH_CF_REQUESTS per level.
+ */
+
+const dir = import.meta.dirname || process.cwd();
+const corpusDir = join(dir, 'compressed');
+const esmDir = join(dir, '../../packages/zstd-wasm-decoder/src/_esm');
+const requests = Number(process.env.BENCH_CF_REQUESTS) || 512;
+const levels = (process.env.BENCH_CF_CONCURRENCY || '1,4,16,64').split(',').map(Number);
+const budgetMB = Number(process.env.BENCH_CF_BUDGET_MB) || 64;
+
+let Miniflare: typeof import('miniflare').Miniflare;
+try {
+  ({ Miniflare } = await import('miniflare'));
+} catch {
+  console.error('miniflare is not installed: pnpm add -D -w miniflare');
+  process.exit(1);
+}
+if (!existsSync(join(esmDir, 'index.cloudflare.js'))) {
+  console.error('Build the decoder first: pnpm run build:decoder');
+  process.exit(1);
+}
+
+const payloads = existsSync(corpusDir)
+  ? readdirSync(corpusDir)
+      .filter((f) => f.endsWith('.zst'))
+      .map((f) => readFileSync(join(corpusDir, f)))
+  : readdirSync(join(dir, '../data')).map((f) => zlib.zstdCompressSync(readFileSync(join(dir, '../data', f))));
+
+const script = `
+import { createDecoder, decompressResponse, getPoolStats, setupCloudflarePool } from './index.cloudflare.js';
+setupCloudflarePool({ memoryBudget: ${budgetMB} * 1024 * 1024 });
+export default {
+  async fetch(request) {
+    const { pathname } = new URL(request.url);
+    if (pathname === '/stats') return Response.json(getPoolStats());
+    if (pathname === '/fresh') {
+      const decoder = await createDecoder();
+      return new Response(decoder.decompressSync(new Uint8Array(await request.arrayBuffer())));
+    }
+    return decompressResponse(new Response(request.body));
+  },
+};`;
+
+const mf = new Miniflare({
+  modules: [
+    { type: 'ESModule', path: join(esmDir, 'worker.js'), contents: script },
+    { type: 'ESModule', path: join(esmDir, 'index.cloudflare.js') },
+    { type: 'CompiledWasm', path: join(esmDir, 'zstd-decoder-perf.wasm') },
+  ],
+  compatibilityDate: '2025-01-01',
+});
+
+const run = async (mode: string, concurrency: number) => {
+  let next = 0;
+  let bytes = 0;
+  const worker = async () => {
+    while (next < requests) {
+      const payload = payloads[next++ % payloads.length];
+      const res = await mf.dispatchFetch(`http://localhost/${mode}`, { method: 'POST', body: payload });
+      if (!res.ok) throw new Error(`${mode}: ${res.status} ${await res.text()}`);
+      bytes += (await res.arrayBuffer()).byteLength;
+    }
+  };
+  const start = performance.now();
+  await Promise.all(Array.from({ length: concurrency }, worker));
+  const seconds = (performance.now() - start) / 1000;
+  return { rps: requests / seconds, mbps: bytes / 1024 / 1024 / seconds };
+};
+
+try {
+  await run('pool', 4);
+  await run('fresh', 4);
+  console.log(`Miniflare: ${payloads.length} payloads, ${requests} requests per level, budget ${budgetMB} MB\n`);
+  console.log(`  ${'concurrency'.padEnd(12)} ${'pool req/s'.padStart(12)} ${'fresh req/s'.padStart(12)} ${'speedup'.padStart(8)}`);
+  for (const concurrency of levels) {
+    const pool = await run('pool', concurrency);
+    const fresh = await run('fresh', concurrency);
+    console.log(
+      `  ${String(concurrency).padEnd(12)} ${pool.rps.toFixed(0).padStart(12)} ${fresh.rps.toFixed(0).padStart(12)} ${(pool.rps / fresh.rps).toFixed(2).padStart(7)}x`,
+    );
+  }
+  console.log(`\npool: ${JSON.stringify(await (await mf.dispatchFetch('http://localhost/stats')).json())}`);
+} finally {
+  await mf.dispose();
+}
@@ -0,0 +1,79 @@
+import { existsSync, readdirSync, readFileSync } from 'node:fs';
+import { join } from 'node:path';
+import * as zlib from 'node:zlib';
+import {
+  compressSync,
+  ZstdCompressionStream,
+} from '../../packages/zstd-wasm-encoder/src/_esm/index.node.js';
+
+/**
+ * zstd-wasm-encoder vs zlib.zstdCompressSync, levels 1-4.
+ *
+ * Inputs: the benchmark corpus (decompressed, `pnpm run bench:setup`) as small payloads,
+ * and the same data concatenated as one large upload. Reports MB/s of uncompressed input
+ * and the compression ratio, plus ZstdCompressionStream throughput on the large payload.
+ */
+
+const dir = import.meta.dirname || process.cwd();
+const corpusDir = join(dir, 'compressed');
+const rounds = Number(process.env.BENCH_ROUNDS) || 5;
+const LEVELS = [1, 2, 3, 4];
+
+const small = existsSync(corpusDir)
+  ? readdirSync(corpusDir)
+      .filter((f) => f.endsWith('.zst'))
+      .map((f) => zlib.zstdDecompressSync(readFileSync(join(corpusDir, f))))
+  : readdirSync(join(dir, '../data')).map((f) => readFileSync(join(dir, '../data', f)));
+const large = Buffer.concat(small);
+const runtime = typeof Bun !== 'undefined' ? 'Bun' : 'Node.js';
+
+const bench = (inputs: Uint8Array[], fn: (input: Uint8Array) => Uint8Array) => {
+  const totalMB = inputs.reduce((sum, b) => sum + b.length, 0) / 1024 / 1024;
+  let compressed = 0;
+  for (const input of inputs) compressed += fn(input).length;
+
+  let best = 0;
+  for (let r = 0; r < rounds; ++r) {
+    const start = performance.now();
+    for (const input of inputs) fn(input);
+    best = Math.max(best, totalMB / ((performance.now() - start) / 1000));
+  }
+  return { mbps: best, ratio: (totalMB * 1024 * 1024) / compressed };
+};
+
+const print = (name: string, { mbps, ratio }: { mbps: number; ratio: number }) =>
+  console.log(`  ${name.padEnd(28)} ${mbps.toFixed(2).padStart(9)} MB/s   ratio ${ratio.toFixed(3)}`);
+
+console.log(`${runtime}: ${small.length} payloads, ${(large.length / 1024 / 1024).toFixed(2)} MB\n`);
+
+for (const [label, inputs] of [
+  ['small payloads', small],
+  ['single large payload', [large]],
+] as const) {
+  console.log(`${label}:`);
+  for (const level of LEVELS) {
+    const params = { [zlib.constants.ZSTD_c_compressionLevel]: level };
+    print(`zlib level ${level}`, bench(inputs, (input) => zlib.zstdCompressSync(input, { params })));
+    print(`wasm level ${level}`, bench(inputs, (input) => compressSync(input, { level })));
+  }
+  console.log('');
+}
+
+console.log('ZstdCompressionStream (64 KB chunks):');
+for (const level of LEVELS) {
+  let best = 0;
+  for (let r = 0; r < rounds; ++r) {
+    const start = performance.now();
+    const stream = new ZstdCompressionStream({ level });
+    const writer = stream.writable.getWriter();
+    const reader = stream.readable.getReader();
+    const drained = (async () => {
+      while (!(await reader.read()).done);
+    })();
+    for (let i = 0; i < large.length; i += 65536) await writer.write(large.subarray(i, i + 65536));
+    await writer.close();
+    await drained;
+    best = Math.max(best, large.length / 1024 / 1024 / ((performance.now() - start) / 1000));
+  }
+  console.log(`  ${`level ${level}`.padEnd(28)} ${best.toFixed(2).padStart(9)} MB/s`);
+}
@@ -0,0 +1,137 @@
+import { existsSync, readdirSync, readFileSync } from 'node:fs';
+import { join } from 'node:path';
+import { Readable, Writable } from 'node:stream';
+import { pipeline } from 'node:stream/promises';
+import * as zlib from 'node:zlib';
+import {
+  createZstdDecompress,
+  ZstdDecompressionStream,
+} from '../../packages/zstd-wasm-decoder/src/_esm/index.node.js';
+
+/**
+ * stream.pipeline() throughput: createZstdDecompress vs zlib.createZstdDecompress.
+ *
+ * The source (benchmark corpus if set up, test/data otherwise) is repeated up to
+ * BENCH_STREAM_MB (default 1024) and compressed once into a single frame, then piped
+ * in 64 KB chunks through each decompressor into a counting Writable.
+ *
+ * Then ZstdDecompressionStream with a consumer that does work of its own (text decoding and
+ * a scan, as a parser would), decoded in-thread vs ahead in a worker ({ worker: true }).
+ */
+
+const dir = import.meta.dirname || process.cwd();
+const corpusDir = join(dir, 'compressed');
+const targetMB = Number(process.env.BENCH_STREAM_MB) || 1024;
+const rounds = Number(process.env.BENCH_STREAM_ROUNDS) || 3;
+const CHUNK = 64 * 1024;
+
+const loadSource = () => {
+  const files = existsSync(corpusDir)
+    ? readdirSync(corpusDir)
+        .filter((f) => f.endsWith('.zst'))
+        .map((f) => zlib.zstdDecompressSync(readFileSync(join(corpusDir, f))))
+    : readdirSync(join(dir, '../data')).map((f) => readFileSync(join(dir, '../data', f)));
+  return Buffer.concat(files);
+};
+
+const compressFrame = async (source: Buffer) => {
+  const target = targetMB * 1024 * 1024;
+  const chunks: Buffer[] = [];
+  await pipeline(
+    Readable.from(
+      (function* () {
+        for (let total = 0; total < target; total += source.length) {
+          yield source.subarray(0, Math.min(source.length, target - total));
+        }
+      })(),
+    ),
+    // Window stays within what the wasm decoder accepts (8 MB)
+    zlib.createZstdCompress({ params: { [zlib.constants.ZSTD_c_windowLog]: 23 } }),
+    new Writable({
+      write(chunk, _encoding, callback) {
+        chunks.push(chunk);
+        callback();
+      },
+    }),
+  );
+  return Buffer.concat(chunks);
+};
+
+const run = async (compressed: Buffer, decompressor: () => NodeJS.ReadWriteStream) => {
+  let bytes = 0;
+  const start = performance.now();
+  await pipeline(
+    Readable.from(
+      (function* () {
+        for (let i = 0; i < compressed.length; i += CHUNK) yield compressed.subarray(i, i + CHUNK);
+      })(),
+    ),
+    decompressor(),
+    new Writable({
+      write(chunk, _encoding, callback) {
+        bytes += chunk.length;
+        callback();
+      },
+    }),
+  );
+  return { bytes, ms: performance.now() - start };
+};
+
+console.log(`Preparing ${targetMB} MB stream...`);
+const compressed = await compressFrame(loadSource());
+console.log(`Compressed: ${(compressed.length / 1024 / 1024).toFixed(2)} MB\n`);
+
+const contenders: Array<[string, () => NodeJS.ReadWriteStream]> = [
+  ['zlib.createZstdDecompress', () => zlib.createZstdDecompress()],
+  ['createZstdDecompress (wasm)', () => createZstdDecompress()],
+];
+
+for (const [name, decompressor] of contenders) {
+  let best = 0;
+  let bytes = 0;
+  for (let r = 0; r < rounds; ++r) {
+    const result = await run(compressed, decompressor);
+    bytes = result.bytes;
+    best = Math.max(best, bytes / 1024 / 1024 / (result.ms / 1000));
+  }
+  console.log(
+    `${name.padEnd(30)} ${best.toFixed(2).padStart(9)} MB/s  (${(bytes / 1024 / 1024).toFixed(0)} MB)`,
+  );
+}
+
+// Stand-in for a parser: decode as text and scan it
+const consume = async (readable: ReadableStream<Uint8Array>) => {
+  const decoder = new TextDecoder();
+  let bytes = 0;
+  let lines = 0;
+  for await (const chunk of readable) {
+    bytes += chunk.length;
+    const text = decoder.decode(chunk, { stream: true });
+    for (let i = text.indexOf('\n'); i != -1; i = text.indexOf('\n', i + 1)) ++lines;
+  }
+  return { bytes, lines };
+};
+
+const runWeb = async (options: { worker?: boolean }) => {
+  const stream = new ZstdDecompressionStream(options);
+  const writer = stream.writable.getWriter();
+  const start = performance.now();
+  const consumed = consume(stream.readable);
+  for (let i = 0; i < compressed.length; i += CHUNK) await writer.write(compressed.subarray(i, i + CHUNK));
+  await writer.close();
+  const { bytes } = await consumed;
+  return { bytes, ms: performance.now() - start };
+};
+
+console.log('\nZstdDecompressionStream + consumer (TextDecoder & scan):');
+for (const [name, options] of [
+  ['in-thread', {}],
+  ['worker (decode-ahead)', { worker: true }],
+] as const) {
+  let best = 0;
+  for (let r = 0; r < rounds; ++r) {
+    const { bytes, ms } = await runWeb(options);
+    best = Math.max(best, bytes / 1024 / 1024 / (ms / 1000));
+  }
+  console.log(`${name.padEnd(30)} ${best.toFixed(2).padStart(9)} MB/s`);
+}
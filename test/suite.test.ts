@@ -1,12 +1,31 @@
 import { Buffer } from 'node:buffer';
 import { spawn } from 'node:child_process';
 import { createHash } from 'node:crypto';
-import { readFileSync } from 'node:fs';
+import { existsSync, readFileSync } from 'node:fs';
 import { dirname, join } from 'node:path';
 import { fileURLToPath } from 'node:url';
+import { PassThrough, Readable } from 'node:stream';
+import { pipeline } from 'node:stream/promises';
+import { promisify } from 'node:util';
+import { constants, zstdCompressSync } from 'node:zlib';
 import { afterAll, beforeAll, describe, expect, test } from 'vitest';
 import { nodeAdapter } from './adapters/node-adapter.ts';
-import { initWasmAdapter, wasmAdapter, ZstdDecompressionStream } from './adapters/wasm-adapter.ts';
+import {
+  decodeRecords,
+  decodeZstdResponse,
+  decompressSync,
+  decompressToString,
+  getHybridMetrics,
+  getResultCacheStats,
+  initWasmAdapter,
+  setupHybridDecoder,
+  setupResultCache,
+  setupZstdDecoder,
+  TarZstReader,
+  wasmAdapter,
+  wasmDecoder,
+  ZstdDecompressionStream,
+} from './adapters/wasm-adapter.ts';
 import { ensureTestData } from './lib/test-data-generator.ts';
 import { hash, slice } from './lib/utils.ts';
 
@@ -258,6 +277,76 @@ describe('WASM decompression', () => {
       expect(hash(decompressed)).toBe(hash(expected));
     });
 
+    test('content size of frames that are not single segment', async () => {
+      // 1 KB window: the header holds a window descriptor, then the dictionary ID & content size
+      const base = loadTestFile('medium-100k.bin');
+      const data = Buffer.concat([base, base]);
+      for (const dictionary of [undefined, testDict]) {
+        const decoder = await wasmDecoder.init(dictionary);
+        for (const size of [60000, 150000]) {
+          const frame = zstdCompressSync(data.subarray(0, size), {
+            params: { [constants.ZSTD_c_windowLog]: 10 },
+            ...(dictionary && { dictionary }),
+          });
+          const frames: [Buffer, number][] = [[frame, size > 65791 ? 2 : 1]];
+          if (size > 65791) {
+            // Same frame with an 8 byte content size field (fcf 3)
+            const fcs = 6 + [0, 1, 2, 4][frame[4] & 3] + 4;
+            const [head, rest] = [frame.subarray(0, fcs), frame.subarray(fcs)];
+            const wide = Buffer.concat([head, Buffer.alloc(4), rest]);
+            wide[4] |= 0xc0;
+            frames.push([wide, 3]);
+          }
+          for (const [f, fcf] of frames) {
+            expect([f[4] >> 6, f[4] & 0x20]).toEqual([fcf, 0]);
+            // Declared size read right: decoded in a single pass, into the decoder's memory
+            const view = decoder.decompressView(f);
+            expect(view.buffer).toBe(decoder.inputBuffer().buffer);
+            expect(hash(Buffer.from(view))).toBe(hash(data.subarray(0, size)));
+          }
+        }
+      }
+    });
+
+    test('decompressView: output in the decoder memory, input read in place', async () => {
+      const decoder = await wasmDecoder.init();
+      const data = loadTestFile('large-512k.bin');
+      const frame = compress(data);
+      const input = decoder.inputBuffer();
+      const view = decoder.decompressView(frame);
+      expect(view.buffer).toBe(input.buffer);
+      expect(hash(Buffer.from(view))).toBe(hash(data));
+
+      // Compressed bytes placed in the source area are not copied again
+      input.set(frame);
+      const inPlace = decoder.decompressView(input.subarray(0, frame.length));
+      expect(inPlace.byteOffset).toBe(view.byteOffset);
+      expect(hash(Buffer.from(inPlace))).toBe(hash(data));
+
+      // Too large for a single pass: streamed into a buffer of its own
+      const large = randomBuffer(16 * 1024 * 1024);
+      const streamed = decoder.decompressView(compress(large));
+      expect(streamed.buffer).not.toBe(input.buffer);
+      expect(hash(Buffer.from(streamed))).toBe(hash(large));
+    });
+
+    test('frames resizing the stream buffers, back to back in one stream', async () => {
+      const decoder = await wasmDecoder.init();
+      const data = Buffer.alloc(3000, 7);
+      const frame = zstdCompressSync(data, { params: { [constants.ZSTD_c_contentSizeFlag]: 0 } });
+      // Same frame declaring a 2^log window: its buffers are sized from it
+      const withWindow = (log: number) => {
+        const f = Buffer.from(frame);
+        f[5] = (log - 10) << 3;
+        return f;
+      };
+      // Growing windows, then enough smaller ones for the oversized buffers to be shrunk
+      const logs = [20, 21, 22, 23, ...Array(130).fill(20), 23];
+      const output = decoder.decompressStream(Buffer.concat(logs.map(withWindow)), true).buf;
+      expect(output.length).toBe(data.length * logs.length);
+      expect(output.every((byte) => byte == 7)).toBe(true);
+    });
+
     test('zero-weight dictionary', async () => {
       const zeroWeightDict = readFileSync(join(EDGE_CASES_DIR, 'dict-files/zero-weight-dict'));
       await testRoundtrip(Buffer.from('Test data without zeros'), {
@@ -578,12 +667,336 @@ describe('Streaming decompression', () => {
       expect(hash(decompressed)).toBe(hash(data));
     });
 
+    test('small writes past the first decode (over 256 KB)', async () => {
+      const data = randomBuffer(512 * 1024);
+      const compressed = compress(data);
+
+      const stream = decompressAdapter.createDecompressionStream
+        ? decompressAdapter.createDecompressionStream()
+        : new ZstdDecompressionStream();
+
+      if (stream._initInBrowser) await stream._initInBrowser();
+
+      const writer = stream.writable.getWriter();
+      const reader = stream.readable.getReader();
+
+      // Everything written before the decoder starts is decoded with the first call
+      (async () => {
+        for (let i = 0; i < compressed.length; i += 4096) {
+          await writer.write(slice(compressed, i, Math.min(i + 4096, compressed.length)));
+        }
+        await writer.close();
+      })();
+
+      const chunks: Uint8Array[] = [];
+      while (true) {
+        const { done, value } = await reader.read();
+        if (done) break;
+        chunks.push(value);
+      }
+
+      expect(hash(Buffer.concat(chunks))).toBe(hash(data));
+    });
+
     test('with dictionary', async () => {
       const data = randomBuffer(50 * 1024);
       const compressed = compress(data, { dictionary: testDict });
       const decompressed = await streamDecompress(compressed, { dictionary: testDict });
       expect(hash(decompressed)).toBe(hash(data));
     });
+
+    test('worker decode-ahead', async () => {
+      const data = loadTestFile('large-1m.bin');
+      const compressed = compress(data);
+
+      const stream = decompressAdapter.createDecompressionStream
+        ? decompressAdapter.createDecompressionStream({ worker: true, queueDepth: 2 })
+        : new ZstdDecompressionStream({ worker: true, queueDepth: 2 });
+
+      if (stream._initInBrowser) await stream._initInBrowser();
+
+      const writer = stream.writable.getWriter();
+      const reader = stream.readable.getReader();
+
+      // One scratch buffer for all writes: chunks are copied before being transferred
+      const chunkSize = 8192;
+      const scratch = new Uint8Array(chunkSize);
+      (async () => {
+        for (let i = 0; i < compressed.length; i += chunkSize) {
+          const part = slice(compressed, i, Math.min(i + chunkSize, compressed.length));
+          scratch.set(part);
+          await writer.write(scratch.subarray(0, part.length));
+        }
+        await writer.close();
+      })();
+
+      const chunks: Uint8Array[] = [];
+      while (true) {
+        const { done, value } = await reader.read();
+        if (done) break;
+        chunks.push(value);
+      }
+
+      expect(hash(Buffer.concat(chunks))).toBe(hash(data));
+    });
+
+    test('decompressSync between the writes of a stream', async () => {
+      const data = loadTestFile('large-1m.bin');
+      const compressed = compress(data);
+      const other = randomBuffer(64 * 1024);
+      const otherCompressed = compress(other);
+
+      // Decoding from the first chunk on: the stream leases a decoder throughout
+      const stream = new ZstdDecompressionStream({ lowLatency: true });
+      const output = new Response(stream.readable).arrayBuffer();
+      const writer = stream.writable.getWriter();
+      for (let i = 0; i < compressed.length; i += 4096) {
+        await writer.write(compressed.subarray(i, i + 4096));
+        if (i % 65536 == 0) expect(hash(decompressSync(otherCompressed))).toBe(hash(other));
+      }
+      await writer.close();
+      expect(hash(Buffer.from(await output))).toBe(hash(data));
+    });
+
+    test('worker decode-ahead with the dictionaries of setupZstdDecoder', async () => {
+      await setupZstdDecoder({ dictionaries: [new Uint8Array(testDict)] });
+      const data = loadTestFile('medium-100k.bin');
+      // No dictionary option: resolved in the worker by the frame's dictionary ID
+      const frame = compress(data, { dictionary: testDict });
+      const stream = new ZstdDecompressionStream({ worker: true });
+      const output = new Response(stream.readable).arrayBuffer();
+      const writer = stream.writable.getWriter();
+      for (let i = 0; i < frame.length; i += 8192) await writer.write(frame.subarray(i, i + 8192));
+      await writer.close();
+      expect(hash(Buffer.from(await output))).toBe(hash(data));
+    });
+  });
+
+  describe('decodeRecords', () => {
+    test('NDJSON records across chunk boundaries', async () => {
+      const lines = Array.from({ length: 100000 }, (_, i) =>
+        JSON.stringify({ i, pad: 'x'.repeat(i % 97) }),
+      );
+      const text = Buffer.from(lines.join('\n'));
+      const compressed = compress(text);
+
+      for (const step of [7, 4096, compressed.length]) {
+        const chunks: Buffer[] = [];
+        for (let i = 0; i < compressed.length; i += step) {
+          chunks.push(slice(compressed, i, i + step));
+        }
+        const records: string[] = [];
+        for await (const batch of decodeRecords(chunks)) {
+          for (const record of batch) records.push(Buffer.from(record).toString());
+        }
+        expect(records.length).toBe(lines.length);
+        expect(hash(Buffer.from(records.join('\n')))).toBe(hash(text));
+      }
+
+      // Empty records, trailing delimiter, other delimiter
+      const batches: string[][] = [];
+      const stream = new ReadableStream({
+        start(controller) {
+          controller.enqueue(compress(Buffer.from('a\0\0b\0')));
+          controller.close();
+        },
+      });
+      for await (const batch of decodeRecords(stream, { delimiter: 0 })) {
+        batches.push(batch.map((record) => Buffer.from(record).toString()));
+      }
+      expect(batches.flat()).toEqual(['a', '', 'b']);
+    });
+  });
+
+  describe('TarZstReader', () => {
+    // ustar header block, checksum included
+    const tarHeader = (name: string, size: number, flag = '0') => {
+      const h = Buffer.alloc(512);
+      h.write(name, 0);
+      h.write('0000644\0', 100);
+      h.write(`${size.toString(8).padStart(11, '0')}\0`, 124);
+      h.write('00000000000\0', 136);
+      h.write(flag, 156);
+      h.write('ustar\x0000', 257);
+      h.fill(32, 148, 156);
+      let sum = 0;
+      for (const byte of h) sum += byte;
+      h.write(`${sum.toString(8).padStart(6, '0')}\0 `, 148);
+      return h;
+    };
+    const padded = (body: Buffer) => Buffer.concat([body, Buffer.alloc((512 - (body.length % 512)) % 512)]);
+
+    const longName = `${'dir/'.repeat(40)}long.txt`;
+    const files: Array<[string, Buffer]> = [
+      ['a.json', Buffer.from(JSON.stringify({ a: 1 }))],
+      ['big.bin', randomBuffer(300000)],
+      ['empty', Buffer.alloc(0)],
+      [longName, Buffer.from('long name')],
+    ];
+    const archive = Buffer.concat([
+      ...files.flatMap(([name, body]) =>
+        name.length > 100
+          ? [
+              tarHeader('././@LongLink', name.length + 1, 'L'),
+              padded(Buffer.from(`${name}\0`)),
+              tarHeader(name.slice(0, 100), body.length),
+              padded(body),
+            ]
+          : [tarHeader(name, body.length), padded(body)],
+      ),
+      Buffer.alloc(1024),
+    ]);
+    const compressed = compress(archive);
+    const chunked = (step: number) => {
+      const chunks: Buffer[] = [];
+      for (let i = 0; i < compressed.length; i += step) chunks.push(slice(compressed, i, i + step));
+      return chunks;
+    };
+
+    test('entries, bodies & long names', async () => {
+      for (const step of [7, 4096, compressed.length]) {
+        const entries: Array<[string, string]> = [];
+        for await (const entry of new TarZstReader(chunked(step))) {
+          entries.push([entry.name, hash(Buffer.from(await entry.bytes()))]);
+        }
+        expect(entries).toEqual(files.map(([name, body]) => [name, hash(body)]));
+      }
+    });
+
+    test('filtered & unread entries are skipped', async () => {
+      const names: string[] = [];
+      const reader = new TarZstReader(chunked(1000), { filter: (h: { size: number }) => h.size < 1000 });
+      for await (const entry of reader) names.push(entry.name);
+      expect(names).toEqual(['a.json', 'empty', longName]);
+
+      let text = '';
+      for await (const entry of new TarZstReader(chunked(1000))) {
+        if (entry.name === longName) text = await entry.text();
+      }
+      expect(text).toBe('long name');
+
+      await expect(async () => {
+        for await (const entry of new TarZstReader([slice(compressed, 0, compressed.length >> 1)])) {
+          await entry.bytes();
+        }
+      }).rejects.toThrow('tar truncated');
+    });
+
+    test('input cut inside the frame, past the end of the archive', async () => {
+      // Everything decodes, end-of-archive blocks included: only the checksum is missing
+      const checked = zstdCompressSync(archive, { params: { [constants.ZSTD_c_checksumFlag]: 1 } });
+      const cut = slice(checked, 0, checked.length - 4);
+      await expect(async () => {
+        for await (const entry of new TarZstReader([cut])) await entry.bytes();
+      }).rejects.toThrow('tar truncated');
+    });
+  });
+
+  describe('text output', () => {
+    const text = 'héllo wörld 日本語 😀 '.repeat(50000);
+    const streamed = Buffer.from(
+      zstdCompressSync(Buffer.from(text), { params: { [constants.ZSTD_c_contentSizeFlag]: 0 } }),
+    );
+
+    test('decompressToString, single pass & streamed', () => {
+      expect(decompressToString(compress(Buffer.from(text)))).toBe(text);
+      expect(decompressToString(streamed)).toBe(text);
+    });
+
+    test("ZstdDecompressionStream({ output: 'text' }) across split sequences", async () => {
+      for (const step of [3, 4099]) {
+        const stream = new ZstdDecompressionStream({ output: 'text' });
+        const writer = stream.writable.getWriter();
+        (async () => {
+          for (let i = 0; i < streamed.length; i += step) {
+            await writer.write(slice(streamed, i, i + step));
+          }
+          await writer.close();
+        })();
+        let out = '';
+        const reader = stream.readable.getReader();
+        for (;;) {
+          const { done, value } = await reader.read();
+          if (done) break;
+          expect(typeof value).toBe('string');
+          out += value;
+        }
+        expect(out).toBe(text);
+      }
+    });
+  });
+
+  describe('decodeZstdResponse', () => {
+    const data = Buffer.concat(Array.from({ length: 6 }, () => loadTestFile('medium-100k.bin')));
+    const frame = zstdCompressSync(data, { params: { [constants.ZSTD_c_contentSizeFlag]: 0 } });
+    const withUrl = (response: Response, url: string) =>
+      Object.defineProperty(response, 'url', { value: url });
+
+    test('Content-Encoding: zstd & .zst assets, others untouched', async () => {
+      const encoded = await decodeZstdResponse(
+        new Response(frame, { headers: { 'content-encoding': 'zstd', 'content-type': 'text/x-test' } }),
+      );
+      expect(encoded.headers.get('content-encoding')).toBeNull();
+      expect(encoded.headers.get('content-type')).toBe('text/x-test');
+      expect(hash(Buffer.from(await encoded.arrayBuffer()))).toBe(hash(data));
+
+      const asset = await decodeZstdResponse(
+        withUrl(new Response(frame, { headers: { 'content-type': 'application/zstd' } }), 'https://a.test/app.json.zst?v=2'),
+      );
+      expect(asset.headers.get('content-type')).toBe('application/json');
+      expect(hash(Buffer.from(await asset.arrayBuffer()))).toBe(hash(data));
+
+      // Decoded by the runtime already, or not zstd at all
+      const plain = await decodeZstdResponse(
+        new Response(data, { headers: { 'content-encoding': 'zstd' } }),
+      );
+      expect(hash(Buffer.from(await plain.arrayBuffer()))).toBe(hash(data));
+      const other = new Response(frame);
+      expect(await decodeZstdResponse(other)).toBe(other);
+    });
+
+    test('output starts before the body is complete', async () => {
+      let body!: ReadableStreamDefaultController<Uint8Array>;
+      const response = await decodeZstdResponse(
+        new Response(
+          new ReadableStream({
+            start(controller) {
+              body = controller;
+              controller.enqueue(frame.subarray(0, frame.length - 8));
+            },
+          }),
+          {
+            headers: { 'content-encoding': 'zstd' },
+          },
+        ),
+      );
+      const reader = response.body!.getReader();
+      const first = await reader.read();
+      expect(first.value!.length).toBeGreaterThan(0);
+      body.enqueue(frame.subarray(frame.length - 8));
+      body.close();
+      const chunks = [first.value!];
+      for (let next = await reader.read(); !next.done; next = await reader.read()) chunks.push(next.value);
+      expect(hash(Buffer.concat(chunks))).toBe(hash(data));
+    });
+
+    test('a body cut inside a frame errors instead of ending early', async () => {
+      const headers = { 'content-encoding': 'zstd' };
+      for (const cut of [frame.subarray(0, frame.length - 8), frame.subarray(0, 10)]) {
+        const response = await decodeZstdResponse(new Response(cut, { headers }));
+        await expect(response.arrayBuffer()).rejects.toThrow('unexpected end of file');
+      }
+    });
+
+    test('a body opening with a skippable frame passes through', async () => {
+      // Magic 0x184D2A50, 4 bytes of user data, then a zstd frame
+      const header = Buffer.from([0x50, 0x2a, 0x4d, 0x18, 4, 0, 0, 0, 1, 2, 3, 4]);
+      const skippable = Buffer.concat([header, frame]);
+      const response = await decodeZstdResponse(
+        new Response(skippable, { headers: { 'content-encoding': 'zstd' } }),
+      );
+      expect(hash(Buffer.from(await response.arrayBuffer()))).toBe(hash(skippable));
+    });
   });
 
   describe('extreme streaming tests', () => {
@@ -632,3 +1045,572 @@ describe('Streaming decompression', () => {
     }, 300000); // 5 minute timeout
   });
 });
+
+describe.skipIf(!setupHybridDecoder)('Hybrid dispatch', () => {
+  const route = (provider: string, r: string) => ({
+    provider,
+    sync: r.repeat(8),
+    async: r.repeat(8),
+  });
+
+  afterAll(async () => {
+    const { provider } = getHybridMetrics();
+    if (provider) await setupHybridDecoder({ calibration: route(provider, 'w') });
+  });
+
+  test('native routes keep wasm results, errors & limits', async () => {
+    const data = loadTestFile('medium-100k.bin');
+    const frame = compress(data, { level: 3 });
+    const calibration = await setupHybridDecoder({ samples: [frame] });
+    if (!calibration) return; // No native zstd in this runtime
+    await setupHybridDecoder({ calibration: route(calibration.provider, 'n') });
+
+    expect(hash(Buffer.from(decompressSync(frame)))).toBe(hash(data));
+    const withDict = compress(data, { dictionary: testDict });
+    expect(
+      hash(Buffer.from(decompressSync(withDict, undefined, { dictionary: testDict }))),
+    ).toBe(hash(data));
+
+    // Concatenated & truncated frames are never routed natively
+    const concatenated = Buffer.concat([frame, compress(Buffer.from('World!'))]);
+    expect(hash(Buffer.from(decompressSync(concatenated)))).toBe(
+      hash(Buffer.concat([data, Buffer.from('World!')])),
+    );
+    expect(() => decompressSync(slice(frame, 0, frame.length - 8))).toThrow(/dec err/);
+
+    for (const file of ['off0.bin.zst', 'truncated_huff_state.zst', 'zeroSeq_extraneous.zst']) {
+      const path = join(EDGE_CASES_DIR, 'golden-decompression-errors', file);
+      expect(() => decompressSync(readFileSync(path))).toThrow(/dec err/);
+    }
+
+    const { sync } = getHybridMetrics();
+    expect(sync.reduce((n, [, native]) => n + native, 0)).toBeGreaterThan(0);
+  });
+});
+
+describe('Result cache', () => {
+  afterAll(() => setupResultCache({ maxBytes: 0 }));
+
+  test('repeated inputs are hits, bounded by bytes, outputs stay private', () => {
+    const snapshot = loadTestFile('repetitive-50k.bin');
+    const frame = compress(snapshot);
+    setupResultCache({ maxBytes: 3 * (snapshot.length + frame.length) });
+
+    const first = decompressSync(frame);
+    first.fill(0);
+    for (let i = 0; i < 4; ++i) {
+      expect(hash(Buffer.from(decompressSync(slice(frame, 0, frame.length))))).toBe(hash(snapshot));
+    }
+    expect(getResultCacheStats()).toMatchObject({ hits: 4, misses: 1, entries: 1, hitRate: 0.8 });
+
+    // Same frame size, other content: a different entry
+    const other = Buffer.from(snapshot).reverse();
+    expect(hash(Buffer.from(decompressSync(compress(other))))).toBe(hash(other));
+    for (const file of ['medium-100k.bin', 'large-512k.bin']) {
+      const data = loadTestFile(file);
+      expect(hash(Buffer.from(decompressSync(compress(data))))).toBe(hash(data));
+    }
+    const { bytes, maxBytes, entries } = getResultCacheStats();
+    expect(bytes).toBeLessThanOrEqual(maxBytes);
+    expect(entries).toBeLessThanOrEqual(3);
+
+    setupResultCache({ maxBytes: 1 << 20, shared: true });
+    expect(decompressSync(frame)).toBe(decompressSync(frame));
+    expect(() => decompressSync(slice(frame, 0, frame.length - 8))).toThrow(/dec err/);
+    expect(getResultCacheStats()).toMatchObject({ hits: 1, misses: 1 });
+  });
+});
+
+// Small window build (make small), instantiated directly
+const SMALL_WASM = join(__dirname, '../packages/zstd-wasm-decoder/src/_esm/zstd-decoder-small.wasm');
+
+describe.skipIf(!existsSync(SMALL_WASM))('Small window build', () => {
+  const windowLog = (data: Buffer, log: number) =>
+    zstdCompressSync(data, { params: { [constants.ZSTD_c_windowLog]: log } });
+
+  test('frames with windows up to 1 MB, single pass & streamed', async () => {
+    const { ZstdDecoder } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const decoder = new ZstdDecoder().init(new WebAssembly.Module(readFileSync(SMALL_WASM)));
+    for (const file of TEST_FILES) {
+      const data = loadTestFile(file);
+      const compressed = windowLog(data, 20);
+      expect(hash(Buffer.from(decoder.decompressSync(compressed)))).toBe(hash(data));
+      expect(hash(Buffer.from(decoder.decompressStream(compressed, true).buf))).toBe(hash(data));
+    }
+    const data = randomBuffer(4 * 1024 * 1024);
+    expect(hash(Buffer.from(decoder.decompressSync(windowLog(data, 20))))).toBe(hash(data));
+  });
+
+  test('larger windows are refused', async () => {
+    const { ZstdDecoder } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const decoder = new ZstdDecoder().init(new WebAssembly.Module(readFileSync(SMALL_WASM)));
+    expect(() => decoder.decompressSync(windowLog(randomBuffer(4 * 1024 * 1024), 22))).toThrow(
+      'win>1mb lim',
+    );
+  });
+});
+
+// Relocatable builds (make pic / pic-shared), in regions of a host memory
+const PIC_WASM = ['zstd-decoder-pic.wasm', 'zstd-decoder-pic-shared.wasm']
+  .map((file) => join(__dirname, '../packages/zstd-wasm-decoder/src/_esm', file))
+  .filter((path) => existsSync(path));
+
+describe.skipIf(!PIC_WASM.length)('Relocatable build', () => {
+  test.each(PIC_WASM)('decoders sharing one memory: %s', async (path) => {
+    const { ZstdDecoder } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const module = new WebAssembly.Module(readFileSync(path));
+    const size = 16 * 1024 * 1024;
+    const memory = new WebAssembly.Memory({
+      initial: (33 * 1024 * 1024) / 65536,
+      maximum: (33 * 1024 * 1024) / 65536,
+      shared: path.endsWith('-shared.wasm'),
+    });
+    const bases = [1024 * 1024, 1024 * 1024 + size];
+    const decoders = bases.map((base) => new ZstdDecoder().init(module, { memory, base, size }));
+    const data = [loadTestFile('medium-100k.bin'), loadTestFile('large-1m.bin')];
+    const frames = data.map((d) => compress(d));
+
+    // Interleaved: single pass views within each region, and streamed
+    for (let round = 0; round < 2; ++round) {
+      for (let i = 0; i < 2; ++i) {
+        const input = decoders[i].inputBuffer();
+        input.set(frames[i]);
+        const view = decoders[i].decompressView(input.subarray(0, frames[i].length));
+        expect(view.buffer).toBe(input.buffer);
+        expect(view.byteOffset).toBeGreaterThanOrEqual(bases[i]);
+        expect(view.byteOffset + view.length).toBeLessThanOrEqual(bases[i] + size);
+        expect(hash(Buffer.from(view))).toBe(hash(data[i]));
+        const streamed = decoders[i].decompressStream(frames[i], true).buf;
+        expect(hash(Buffer.from(streamed))).toBe(hash(data[i]));
+      }
+    }
+
+    expect(() => new ZstdDecoder().init(module, { memory, base: bases[0] + 8, size })).toThrow(
+      'bad region',
+    );
+    expect(() => new ZstdDecoder().init(module, { memory, base: bases[1] + size, size })).toThrow(
+      'bad region',
+    );
+  });
+
+  test.each(PIC_WASM)('frame buffers larger than the region: %s', async (path) => {
+    const { ZstdDecoder } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const module = new WebAssembly.Module(readFileSync(path));
+    const memory = new WebAssembly.Memory({
+      initial: 80,
+      maximum: 80,
+      shared: path.endsWith('-shared.wasm'),
+    });
+    const decoder = new ZstdDecoder().init(module, { memory, base: 1024 * 1024, size: 4 << 20 });
+    const data = Buffer.alloc(3000, 7);
+    const frame = zstdCompressSync(data, { params: { [constants.ZSTD_c_contentSizeFlag]: 0 } });
+    // 8 MB window declared: its stream buffers don't fit the 4 MB region's arena
+    const wide = Buffer.from(frame);
+    wide[5] = (23 - 10) << 3;
+    expect(() => decoder.decompressStream(wide, true)).toThrow('dec err -64');
+    expect(decoder.decompressStream(frame, true).buf).toEqual(new Uint8Array(data));
+  });
+});
+
+// Entropy table cache (perf build)
+const PERF_WASM = join(__dirname, '../packages/zstd-wasm-decoder/src/_esm/zstd-decoder-perf.wasm');
+
+describe.skipIf(!existsSync(PERF_WASM))('Entropy table cache', () => {
+  test('identical small frames reuse their tables, distinct ones still decode', async () => {
+    const { ZstdDecoder } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const decoder = new ZstdDecoder().init(new WebAssembly.Module(readFileSync(PERF_WASM)));
+    const message = loadTestFile('test.json').subarray(0, 900);
+    const frame = compress(message);
+    for (let i = 0; i < 4; ++i) {
+      expect(hash(Buffer.from(decoder.decompressSync(frame)))).toBe(hash(message));
+    }
+    const { huffman } = decoder.tableCacheStats();
+    expect(huffman.misses).toBe(1);
+    expect(huffman.hits).toBe(3);
+
+    for (const file of TEST_FILES) {
+      const data = loadTestFile(file);
+      expect(hash(Buffer.from(decoder.decompressSync(compress(data))))).toBe(hash(data));
+    }
+  });
+});
+
+describe.skipIf(!existsSync(PERF_WASM))('Output fingerprint', () => {
+  test('XXH3-64 / 128 of the output, single pass & streamed', async () => {
+    const { ZstdDecoder } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const module = new WebAssembly.Module(readFileSync(PERF_WASM));
+    const xxh64 = new ZstdDecoder({ fingerprint: 'xxh3-64' }).init(module);
+    const xxh128 = new ZstdDecoder({ fingerprint: 'xxh3-128' }).init(module);
+    const frame = compress(loadTestFile('test.json'));
+
+    xxh64.decompressSync(frame);
+    expect(xxh64.fingerprint()).toBe(0x830ee717784ee731n);
+    xxh128.decompressSync(compress(loadTestFile('tiny-256b.bin')));
+    expect(xxh128.fingerprint()).toBe(0x0746f1516906a44b4f06f7fb4e5dcb83n);
+
+    let last: bigint | undefined;
+    for (let i = 0; i < frame.length; i += 997) {
+      last = xxh64.decompressStream(frame.subarray(i, i + 997), i == 0).fingerprint;
+    }
+    expect(last).toBe(0x830ee717784ee731n);
+    xxh64.decompressSync(compress(Buffer.alloc(0)));
+    expect(xxh64.fingerprint()).toBe(0x2d06800538d394c2n);
+
+    expect(() => new ZstdDecoder().init(module).fingerprint()).toThrow('fingerprint off');
+  });
+});
+
+describe.skipIf(!existsSync(PERF_WASM))('Stream checkpoint', () => {
+  test('resume a stream in another instance, across window wraps', async () => {
+    const { ZstdDecoder } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const module = new WebAssembly.Module(readFileSync(PERF_WASM));
+    const data = Buffer.concat(Array.from({ length: 8 }, () => loadTestFile('medium-100k.bin')));
+    // Streamed frame (no content size) with a 128 KB window: the ring buffer wraps
+    const frame = Buffer.from(
+      zstdCompressSync(data, {
+        params: {
+          [constants.ZSTD_c_contentSizeFlag]: 0,
+          [constants.ZSTD_c_windowLog]: 17,
+          [constants.ZSTD_c_checksumFlag]: 1,
+        },
+      }),
+    );
+
+    let decoder = new ZstdDecoder({ fingerprint: 'xxh3-64' }).init(module);
+    const chunks: Uint8Array[] = [];
+    for (let i = 0; i < frame.length; i += 4099) {
+      chunks.push(decoder.decompressStream(frame.subarray(i, i + 4099), i == 0).buf);
+      const snapshot = decoder.checkpoint();
+      expect(snapshot.length).toBeLessThan(131072 + 131072);
+      decoder = new ZstdDecoder({ fingerprint: 'xxh3-64' }).init(module);
+      decoder.restore(snapshot);
+    }
+    expect(hash(Buffer.concat(chunks))).toBe(hash(data));
+    const whole = new ZstdDecoder({ fingerprint: 'xxh3-64' }).init(module);
+    expect(decoder.fingerprint()).toBe(whole.decompressStream(frame, true).fingerprint);
+
+    const snapshot = decoder.checkpoint();
+    expect(() => new ZstdDecoder().init(module).restore(snapshot)).toThrow('snapshot mismatch');
+    expect(() =>
+      new ZstdDecoder({ dictionary: testDict }).init(module).restore(snapshot),
+    ).toThrow('snapshot mismatch');
+  });
+});
+
+describe.skipIf(!existsSync(PERF_WASM))('Memory calibration', () => {
+  test('high-water mark per window size, limits & small build fit', async () => {
+    const { calibrateMemory } = await import('../packages/zstd-wasm-decoder/src/_esm/index.node.js');
+    const data = Buffer.concat(Array.from({ length: 24 }, () => loadTestFile('medium-100k.bin')));
+    const streamed = (windowLog: number) =>
+      zstdCompressSync(data, {
+        params: { [constants.ZSTD_c_contentSizeFlag]: 0, [constants.ZSTD_c_windowLog]: windowLog },
+      });
+
+    const calibration = await calibrateMemory([streamed(17), streamed(20), compress(data.subarray(0, 65536))]);
+    const [single, w17, w20] = calibration.windows;
+    expect(calibration.windows.map((w) => w.windowSize)).toEqual([65536, 131072, 1048576]);
+    expect(single.arena).toBe(65536);
+    expect(w17.arena).toBeGreaterThan(131072);
+    expect(w20.arena).toBeGreaterThan(1048576);
+    expect(w20.memory - w20.arena).toBe(w17.memory - w17.arena);
+    expect(calibration.memorySize % 65536).toBe(0);
+    expect(calibration.memorySize).toBeGreaterThanOrEqual(w20.memory);
+    expect(calibration.maxDstSize).toBe(8388608);
+    expect(calibration.small).toBe(true);
+    expect((await calibrateMemory([streamed(23)])).small).toBe(false);
+  });
+
+  test('decoders are destroyed when a sample fails', async () => {
+    const { calibrateMemory, ZstdDecoder } = await import(
+      '../packages/zstd-wasm-decoder/src/_esm/index.node.js'
+    );
+    const destroy = ZstdDecoder.prototype._destroy;
+    let destroyed = 0;
+    ZstdDecoder.prototype._destroy = function (this: typeof ZstdDecoder.prototype) {
+      ++destroyed;
+      destroy.call(this);
+    };
+    try {
+      const corrupt = Buffer.from(compress(loadTestFile('medium-100k.bin')));
+      corrupt.fill(0xff, 32);
+      await expect(calibrateMemory([compress(testDict), corrupt])).rejects.toThrow();
+      expect(destroyed).toBe(1);
+    } finally {
+      ZstdDecoder.prototype._destroy = destroy;
+    }
+  });
+});
+
+// Workers decoder pool, from source: the cloudflare entry imports its wasm as a module
+const cloudflarePool = await import('../packages/zstd-wasm-decoder/src/cloudflare-pool.ts');
+
+describe('Cloudflare decoder pool', () => {
+  const MB = 1024 * 1024;
+  // Stand-ins: the pool only sizes and destroys its decoders
+  const destroyed: number[] = [];
+  let created = 0;
+  const create = (fail = false) => () => {
+    if (fail) throw new Error('dict err');
+    const id = created++;
+    return { id, _memorySize: () => 16 * MB, _destroy: () => destroyed.push(id) } as any;
+  };
+
+  test('leases within the memory budget, waiters get released decoders', async () => {
+    const pool = new cloudflarePool.WorkersDecoderPool({ memoryBudget: 32 * MB });
+    const [a, ia] = await pool.acquire(0, create());
+    await pool.acquire(0, create());
+    expect(pool.stats()).toMatchObject({ max: 2, size: 2, leased: 2, instanceMemory: 16 * MB });
+
+    const waiter = pool.acquire(0, create());
+    expect(pool.stats().waiting).toBe(1);
+    // Synchronous callers past the budget get an ephemeral decoder
+    expect(pool.acquireSync(0, create())[1]).toBe(-1);
+    pool.release(ia);
+    pool.release(ia);
+    expect(await waiter).toEqual([a, ia]);
+    expect(pool.stats()).toMatchObject({ size: 2, leased: 2, waiting: 0 });
+  });
+
+  test('free decoders of other dictionaries are re-created, no stale slot on failure', async () => {
+    const pool = new cloudflarePool.WorkersDecoderPool({ memoryBudget: 16 * MB });
+    const [a, ia] = await pool.acquire(0, create());
+    pool.release(ia);
+    const [b, ib] = await pool.acquire(5, create());
+    expect(destroyed).toContain(a.id);
+    pool.release(ib);
+
+    await expect(pool.acquire(7, create(true))).rejects.toThrow('dict err');
+    expect(destroyed).toContain(b.id);
+    // The emptied slot is not handed out as a decoder of dictionary 5
+    const [c] = await pool.acquire(5, create());
+    expect(c).toBeTruthy();
+    expect(c).not.toBe(b);
+  });
+
+  test('failed creates pass the wake-up on, a larger budget wakes several waiters', async () => {
+    const pool = new cloudflarePool.WorkersDecoderPool({ memoryBudget: 16 * MB });
+    const [, i0] = await pool.acquire(0, create());
+    const failing = pool.acquire(7, create(true));
+    const next = pool.acquire(0, create());
+    expect(pool.stats().waiting).toBe(2);
+    pool.release(i0);
+    await expect(failing).rejects.toThrow('dict err');
+    expect((await next)[0]).toBeTruthy();
+
+    const waiters = [pool.acquire(0, create()), pool.acquire(0, create())];
+    expect(pool.stats().waiting).toBe(2);
+    pool.configure({ memoryBudget: 48 * MB });
+    expect((await Promise.all(waiters)).map(([, idx]) => idx).sort()).toEqual([1, 2]);
+    expect(pool.stats()).toMatchObject({ max: 3, size: 3, leased: 3, waiting: 0 });
+  });
+
+  describe.skipIf(!existsSync(PERF_WASM))('with wasm decoders', () => {
+    let shared: typeof import('../packages/zstd-wasm-decoder/src/shared.ts');
+    const leased = () => cloudflarePool.getPoolStats().leased;
+
+    beforeAll(async () => {
+      shared = await import('../packages/zstd-wasm-decoder/src/shared.ts');
+      const module = new WebAssembly.Module(readFileSync(PERF_WASM));
+      shared._internal._loader = () => module;
+      cloudflarePool._installPool();
+    });
+
+    test('decompressResponse releases its decoder once read, failed or canceled', async () => {
+      const data = loadTestFile('large-1m.bin');
+      const frame = compress(data);
+      const headers = { 'content-encoding': 'zstd', 'content-type': 'text/x-test' };
+      const response = cloudflarePool.decompressResponse(new Response(frame, { headers }));
+      expect(response.headers.get('content-encoding')).toBeNull();
+      expect(response.headers.get('content-type')).toBe('text/x-test');
+      expect(hash(Buffer.from(await response.arrayBuffer()))).toBe(hash(data));
+      expect(leased()).toBe(0);
+
+      const reader = cloudflarePool.decompressResponse(new Response(frame)).body!.getReader();
+      expect((await reader.read()).value!.length).toBeGreaterThan(0);
+      expect(leased()).toBe(1);
+      await reader.cancel();
+      expect(leased()).toBe(0);
+
+      const corrupt = Buffer.from(frame);
+      corrupt.fill(0xff, 32);
+      const failed = cloudflarePool.decompressResponse(new Response(corrupt));
+      await expect(failed.arrayBuffer()).rejects.toThrow();
+      expect(leased()).toBe(0);
+
+      const cut = cloudflarePool.decompressResponse(new Response(frame.subarray(0, -8)));
+      await expect(cut.arrayBuffer()).rejects.toThrow('unexpected end of file');
+      expect(leased()).toBe(0);
+    });
+
+    test('Service Worker responses wait for the dictionaries only when decoded', async () => {
+      const { _decodeResponse } = await import('../packages/zstd-wasm-decoder/src/response.ts');
+      let open!: () => void;
+      // As registerZstdServiceWorker does: the dictionaries are loaded once ready is released
+      const ready = new Promise<void>((resolve) => (open = resolve)).then(() =>
+        shared.setupZstdDecoder({ dictionaries: [new Uint8Array(testDict)] }),
+      );
+      const headers = { 'content-encoding': 'zstd' };
+      const plain = await _decodeResponse(new Response('plain', { headers }), {}, ready);
+      expect(await plain.text()).toBe('plain');
+
+      // Compressed with test.dict, resolved by the ID of its header
+      const data = loadTestFile('medium-100k.bin');
+      const frame = compress(data, { dictionary: testDict });
+      let decoded: Response | null = null;
+      const pending = _decodeResponse(new Response(frame, { headers }), {}, ready);
+      pending.then((response) => (decoded = response));
+      await new Promise((resolve) => setTimeout(resolve, 10));
+      expect(decoded).toBeNull();
+      open();
+      expect(hash(Buffer.from(await (await pending).arrayBuffer()))).toBe(hash(data));
+    });
+
+    test('ZstdDecompressionStream returns its decoder when canceled', async () => {
+      const frame = compress(randomBuffer(512 * 1024));
+      const stream = new shared.ZstdDecompressionStream();
+      const writer = stream.writable.getWriter();
+      for (let i = 0; i < frame.length; i += 4096) {
+        writer.write(frame.subarray(i, i + 4096)).catch(() => {});
+      }
+      const reader = stream.readable.getReader();
+      expect((await reader.read()).value!.length).toBeGreaterThan(0);
+      expect(leased()).toBe(1);
+      await reader.cancel();
+      expect(leased()).toBe(0);
+    });
+  });
+});
+
+// Node only (worker_threads)
+const zlibShim = await import('../packages/zstd-wasm-decoder/src/_esm/index.zlib.js').catch(
+  () => null,
+);
+
+describe.skipIf(!zlibShim)('zlib shim (zstd-wasm-decoder/zlib)', () => {
+  test('sync & async match zlib, including concatenated frames & dictionaries', async () => {
+    const { zstdDecompress, zstdDecompressSync } = zlibShim!;
+    const data = loadTestFile('medium-100k.bin');
+    const inputs = [
+      [compress(data), data],
+      [
+        Buffer.concat([compress(data), compress(Buffer.from('World!'))]),
+        Buffer.concat([data, Buffer.from('World!')]),
+      ],
+      [compress(data, { dictionary: testDict }), data, { dictionary: testDict }],
+    ] as const;
+    for (const [input, expected, options] of inputs) {
+      expect(hash(zstdDecompressSync(input, options))).toBe(hash(expected));
+      const result = await promisify(zstdDecompress)(input, options);
+      expect(hash(result)).toBe(hash(expected));
+    }
+  });
+
+  test('zlib errors: maxOutputLength, windowLogMax, corrupted input', async () => {
+    const { constants, zstdDecompress, zstdDecompressSync } = zlibShim!;
+    const frame = compress(loadTestFile('large-1m.bin'));
+    expect(() => zstdDecompressSync(frame, { maxOutputLength: 1024 })).toThrow(
+      expect.objectContaining({ code: 'ERR_BUFFER_TOO_LARGE' }),
+    );
+    await expect(promisify(zstdDecompress)(frame, { maxOutputLength: 1024 })).rejects.toThrow(
+      expect.objectContaining({ code: 'ERR_BUFFER_TOO_LARGE' }),
+    );
+    expect(() =>
+      zstdDecompressSync(frame, { params: { [constants.ZSTD_d_windowLogMax]: 10 } }),
+    ).toThrow(expect.objectContaining({ code: 'ZSTD_error_frameParameter_windowTooLarge' }));
+    expect(() => zstdDecompressSync(Buffer.from('not a zstd frame'))).toThrow(
+      expect.objectContaining({ code: 'ZSTD_error_prefix_unknown', errno: 10 }),
+    );
+  });
+});
+
+describe.skipIf(!zlibShim)('createZstdDecompress (node:stream)', () => {
+  const collect = async (stream: NodeJS.ReadableStream) => {
+    const chunks: Buffer[] = [];
+    for await (const chunk of stream) chunks.push(chunk as Buffer);
+    return Buffer.concat(chunks);
+  };
+
+  test('pipeline of small chunks, concatenated frames & dictionaries', async () => {
+    const { createZstdDecompress } = zlibShim!;
+    const data = loadTestFile('large-1m.bin');
+    const tail = loadTestFile('medium-10k.bin');
+    const dictionary = testDict;
+    const input = Buffer.concat([compress(data, { dictionary }), compress(tail, { dictionary })]);
+    const chunks = Array.from({ length: Math.ceil(input.length / 1000) }, (_, i) =>
+      input.subarray(i * 1000, (i + 1) * 1000),
+    );
+    const stream = createZstdDecompress({ dictionary });
+    const output = collect(stream);
+    await pipeline(Readable.from(chunks), stream);
+    expect(hash(await output)).toBe(hash(Buffer.concat([data, tail])));
+    expect(stream.bytesWritten).toBe(input.length);
+  });
+
+  test('pauses while the readable side is full', async () => {
+    const { createZstdDecompress } = zlibShim!;
+    const data = Buffer.alloc(64 << 20);
+    const stream = createZstdDecompress();
+    stream.end(compress(data));
+    await new Promise((resolve) => setTimeout(resolve, 50));
+    expect(stream.readableLength).toBeLessThan(16 << 20);
+    expect((await collect(stream)).equals(data)).toBe(true);
+  });
+
+  test('reset() drops the frame in progress', async () => {
+    const { createZstdDecompress } = zlibShim!;
+    const first = compress(loadTestFile('medium-100k.bin'));
+    const data = loadTestFile('large-512k.bin');
+    const stream = createZstdDecompress();
+    const output = collect(stream);
+    await new Promise((resolve) => stream.write(first.subarray(0, first.length >> 1), resolve));
+    stream.reset();
+    stream.end(compress(data));
+    expect(hash((await output).subarray(-data.length))).toBe(hash(data));
+  });
+
+  test('input ending inside a frame: unexpected end of file', async () => {
+    const { createZstdDecompress } = zlibShim!;
+    const frame = compress(loadTestFile('medium-100k.bin'));
+    for (const input of [frame.subarray(0, -3), frame.subarray(0, 10)]) {
+      const sink = new PassThrough().resume();
+      await expect(pipeline(Readable.from([input]), createZstdDecompress(), sink)).rejects.toThrow(
+        expect.objectContaining({ message: 'unexpected end of file', code: 'Z_BUF_ERROR' }),
+      );
+    }
+  });
+});
+
+// Built separately (pnpm run build:encoder)
+const encoder = await import('../packages/zstd-wasm-encoder/src/_esm/index.node.js').catch(
+  () => null,
+);
+
+describe.skipIf(!encoder)('WASM compression (zstd-wasm-encoder)', () => {
+  test('levels 1-4 roundtrip through zlib & the wasm decoder', async () => {
+    for (const file of TEST_FILES) {
+      const data = loadTestFile(file);
+      for (const level of [1, 2, 3, 4]) {
+        const compressed = encoder!.compressSync(data, { level });
+        expect(hash(nodeAdapter.decompress(Buffer.from(compressed)))).toBe(hash(data));
+        expect(hash(await decompress(compressed))).toBe(hash(data));
+      }
+    }
+  });
+
+  test('inputs above the single pass buffer keep their content size', async () => {
+    const data = randomBuffer(16 * 1024 * 1024);
+    const compressed = await encoder!.compress(data, { level: 1, checksum: true });
+    // Frame header descriptor: content size field & checksum flag
+    expect(compressed[4] >> 6).toBe(2);
+    expect((compressed[4] >> 2) & 1).toBe(1);
+    expect(hash(nodeAdapter.decompress(Buffer.from(compressed)))).toBe(hash(data));
+    expect(hash(await decompress(compressed))).toBe(hash(data));
+  });
+
+  test('ZstdCompressionStream', async () => {
+    const data = loadTestFile('large-1m.bin');
+    const stream = new Blob([data]).stream().pipeThrough(new encoder!.ZstdCompressionStream());
+    const compressed = Buffer.from(await new Response(stream).arrayBuffer());
+    expect(hash(nodeAdapter.decompress(compressed))).toBe(hash(data));
+  });
+});